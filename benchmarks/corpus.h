@@ -0,0 +1,449 @@
+// Synthetic timestamps for the benchmarks: every layout the README
+// lists, plus inputs every parser must reject, generated from a seed so
+// that runs compare like with like. save_corpus and load_corpus carry
+// a corpus between programs, see corpus_gen.
+
+#ifndef _DATETIMELITE_BENCH_CORPUS_H_
+#define _DATETIMELITE_BENCH_CORPUS_H_
+#include <cstddef>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "datetimelite.h"
+
+namespace bench {
+
+enum class corpus_format {
+  http,         // Wed, 09 Feb 1994 22:23:32 GMT
+  rfc850,       // Wednesday, 09-Feb-94 22:23:32 GMT
+  clf,          // 09/Feb/1994:22:23:32 -0700
+  iso8601,      // 1994-02-09 22:23:32
+  iso8601_utc,  // 1994-02-09T22:23:32.123Z
+  compact,      // 19940209T222332
+  date_only,    // 1994-02-09
+  invalid,      // one of the above broken, or not a date at all
+};
+
+static const corpus_format all_formats[] = {
+  corpus_format::http, corpus_format::rfc850, corpus_format::clf, corpus_format::iso8601,
+  corpus_format::iso8601_utc, corpus_format::compact, corpus_format::date_only, corpus_format::invalid,
+};
+
+static const char*
+format_name(corpus_format f)
+{
+  static const char* const names[] = {
+    "http", "rfc850", "clf", "iso8601", "iso8601_utc", "compact", "date_only", "invalid",
+  };
+  return names[static_cast<int>(f)];
+}
+
+// The format called name, false if there is none.
+static bool
+format_from_name(std::string_view name, corpus_format& f)
+{
+  for (corpus_format g : all_formats) {
+    if (name == format_name(g)) {
+      f = g;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Timestamps one after another, each followed by a NUL so that C APIs
+// can read them in place: string i is data[offsets[i], offsets[i + 1] - 1).
+struct corpus {
+  std::string data;
+  std::vector<uint32_t> offsets = { 0 };
+
+  std::size_t
+  size() const
+  {
+    return offsets.size() - 1;
+  }
+
+  const char*
+  c_str(std::size_t i) const
+  {
+    return data.data() + offsets[i];
+  }
+
+  std::size_t
+  length(std::size_t i) const
+  {
+    return offsets[i + 1] - offsets[i] - 1;
+  }
+
+  // Bytes of the timestamps, without the NULs.
+  std::size_t
+  bytes() const
+  {
+    return data.size() - size();
+  }
+
+  void
+  push_back(const char* s, std::size_t len)
+  {
+    data.append(s, len);
+    data.push_back('\0');
+    offsets.push_back(static_cast<uint32_t>(data.size()));
+  }
+};
+
+static const char* const month_names[] = {
+  "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
+};
+static const char* const weekday_names[] = {
+  "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday",
+};
+
+// Writes t in format f, which must not be invalid, into buf and
+// returns the length. zone is seconds east of UTC; nsec is the fraction
+// of iso8601_utc, written with fraction_digits digits and no dot for 0.
+// Without a suffix each layout gets its usual zone, only clf at offset
+// zone: GMT for http and rfc850, the offset for clf, Z for
+// iso8601_utc. With one, the fields are shown at offset zone and the
+// suffix, which must spell that offset, follows them.
+static std::size_t
+write_timestamp(char* buf, std::size_t size, corpus_format f, int64_t t, int nsec = 0, int zone = 0,
+                const char* suffix = nullptr, int fraction_digits = 3)
+{
+  const int shown = suffix || f == corpus_format::clf ? zone : 0;
+  const datetimelite::datetime local = datetimelite::from_epoch(t, 0, shown);
+  const int64_t lt = t + shown;
+  const char* mon = month_names[local.mon - 1];
+  const int wday = static_cast<int>(((lt >= 0 ? lt : lt - 86399) / 86400 % 7 + 11) % 7);
+  int n = 0;
+  switch (f) {
+  case corpus_format::http:
+    n = std::snprintf(buf, size, "%.3s, %02d %s %04d %02d:%02d:%02d", weekday_names[wday],
+                      local.mday, mon, local.year, local.hour, local.min, local.sec);
+    break;
+  case corpus_format::rfc850:
+    n = std::snprintf(buf, size, "%s, %02d-%s-%02d %02d:%02d:%02d", weekday_names[wday],
+                      local.mday, mon, local.year % 100, local.hour, local.min, local.sec);
+    break;
+  case corpus_format::clf:
+    n = std::snprintf(buf, size, "%02d/%s/%04d:%02d:%02d:%02d", local.mday, mon, local.year,
+                      local.hour, local.min, local.sec);
+    break;
+  case corpus_format::iso8601:
+    n = std::snprintf(buf, size, "%04d-%02d-%02d %02d:%02d:%02d", local.year, local.mon, local.mday,
+                      local.hour, local.min, local.sec);
+    break;
+  case corpus_format::iso8601_utc: {
+    int frac = nsec;
+    for (int d = fraction_digits; d < 9; ++d)
+      frac /= 10;
+    n = std::snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d%s%0*d", local.year, local.mon, local.mday,
+                      local.hour, local.min, local.sec, fraction_digits ? "." : "", fraction_digits, frac);
+    if (fraction_digits == 0 && n > 0)
+      buf[--n] = '\0';  // %0*d wrote a 0 for no digits
+    break;
+  }
+  case corpus_format::compact:
+    n = std::snprintf(buf, size, "%04d%02d%02dT%02d%02d%02d", local.year, local.mon, local.mday,
+                      local.hour, local.min, local.sec);
+    break;
+  case corpus_format::date_only:
+    n = std::snprintf(buf, size, "%04d-%02d-%02d", local.year, local.mon, local.mday);
+    break;
+  case corpus_format::invalid:
+    break;
+  }
+  if (n <= 0 || static_cast<std::size_t>(n) >= size)
+    return 0;
+
+  char usual[12] = "";
+  if (!suffix) {
+    const int m = (zone < 0 ? -zone : zone) / 60;
+    if (f == corpus_format::http || f == corpus_format::rfc850)
+      std::strcpy(usual, " GMT");
+    else if (f == corpus_format::clf)
+      std::snprintf(usual, sizeof(usual), " %c%02d%02d", zone < 0 ? '-' : '+', m / 60, m % 60);
+    else if (f == corpus_format::iso8601_utc)
+      std::strcpy(usual, "Z");
+    suffix = usual;
+  }
+  const int z = std::snprintf(buf + n, size - n, "%s", suffix);
+  return z >= 0 && static_cast<std::size_t>(n + z) < size ? n + z : 0;
+}
+
+// An input every parser rejects: a valid timestamp with one field out
+// of range or cut short, or text that is no date at all.
+static std::size_t
+write_invalid(char* buf, std::size_t size, int64_t t, std::mt19937_64& rng)
+{
+  const datetimelite::datetime utc = datetimelite::from_epoch(t);
+  int n = 0;
+  switch (rng() % 6) {
+  case 0:
+    n = std::snprintf(buf, size, "%04d-13-%02d %02d:%02d:%02d", utc.year, utc.mday, utc.hour, utc.min, utc.sec);
+    break;
+  case 1:
+    n = std::snprintf(buf, size, "Wed, 31 Feb %04d %02d:%02d:%02d GMT", utc.year, utc.hour, utc.min, utc.sec);
+    break;
+  case 2:
+    n = std::snprintf(buf, size, "%02d/Foo/%04d:%02d:%02d:%02d +0000", utc.mday, utc.year, utc.hour, utc.min, utc.sec);
+    break;
+  case 3:
+    n = std::snprintf(buf, size, "%04d-%02d-%02dT25:%02d:%02dZ", utc.year, utc.mon, utc.mday, utc.min, utc.sec);
+    break;
+  case 4:
+    n = std::snprintf(buf, size, "%04d-%02d", utc.year, utc.mon);
+    break;
+  default:
+    n = std::snprintf(buf, size, "not a date #%u", static_cast<unsigned>(rng() % 100000));
+    break;
+  }
+  return n > 0 ? static_cast<std::size_t>(n) : 0;
+}
+
+// Range of the instants, in epoch seconds. rfc850 has a two digit year
+// which the parsers read as 19xx, so it stays in the 20th century.
+static void
+epoch_range(corpus_format f, int64_t& lo, int64_t& hi)
+{
+  lo = 0;                                                     // 1970-01-01
+  hi = f == corpus_format::rfc850 ? 946684799 : 2145916799;   // 1999-12-31, 2037-12-31
+}
+
+// n timestamps of format f, at random instants drawn from seed.
+static corpus
+make_corpus(corpus_format f, std::size_t n, uint64_t seed)
+{
+  std::mt19937_64 rng(seed ^ (static_cast<uint64_t>(f) << 32));
+  int64_t lo, hi;
+  epoch_range(f, lo, hi);
+  std::uniform_int_distribution<int64_t> when(lo, hi);
+  corpus c;
+  char buf[64];
+  for (std::size_t i = 0; i < n; ++i) {
+    const int64_t t = when(rng);
+    const std::size_t len = f == corpus_format::invalid
+      ? write_invalid(buf, sizeof(buf), t, rng)
+      : write_timestamp(buf, sizeof(buf), f, t, static_cast<int>(rng() % 1000) * 1000000,
+                        (static_cast<int>(rng() % 49) - 24) * 1800);
+    c.push_back(buf, len);
+  }
+  return c;
+}
+
+// How the layouts that can carry a zone get one; date_only never does.
+enum class zone_mix {
+  usual,    // as make_corpus: GMT, the offset on clf, Z, none on the rest
+  utc,      // all at UTC, spelled GMT, +0000, UTC or Z as each layout is
+  offsets,  // numeric offsets, whole and half hours from -12:00 to +12:00
+  names,    // abbreviations of zone_registry: UT, GMT, EST, PDT, military
+  mixed,    // utc, offsets or names, a third each
+};
+
+static const char*
+zone_mix_name(zone_mix z)
+{
+  static const char* const names[] = { "usual", "utc", "offsets", "names", "mixed" };
+  return names[static_cast<int>(z)];
+}
+
+static bool
+zone_mix_from_name(std::string_view name, zone_mix& z)
+{
+  for (int i = 0; i <= static_cast<int>(zone_mix::mixed); ++i) {
+    if (name == zone_mix_name(static_cast<zone_mix>(i))) {
+      z = static_cast<zone_mix>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+// What generate_corpus makes.
+struct corpus_options {
+  // The layouts, one drawn at random for each row.
+  std::vector<corpus_format> formats = {
+    corpus_format::http, corpus_format::rfc850, corpus_format::clf, corpus_format::iso8601,
+    corpus_format::iso8601_utc, corpus_format::compact, corpus_format::date_only,
+  };
+  double invalid_share = 0;   // of the rows, from 0 to 1
+  zone_mix zones = zone_mix::usual;
+  int min_fraction = 3;       // digits of the iso8601_utc fraction, 0 to 9
+  int max_fraction = 3;
+  bool sorted = false;        // by instant, as in a log, instead of at random
+};
+
+// Writes the zone of a timestamp of format f drawn as z says into
+// suffix, and its offset into zone. Empty for the usual zone.
+static void
+draw_zone(corpus_format f, zone_mix z, std::mt19937_64& rng, char (&suffix)[12], int& zone)
+{
+  static const char* const names[] = {
+    "UT", "UTC", "GMT", "Z", "EST", "EDT", "CST", "CDT", "MST", "MDT", "PST", "PDT",
+    "A", "B", "C", "D", "E", "F", "G", "H", "I", "K", "L", "M",
+    "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y",
+  };
+  const bool attached = f == corpus_format::iso8601_utc || f == corpus_format::compact;
+  suffix[0] = '\0';
+  zone = 0;
+  if (z == zone_mix::mixed)
+    z = static_cast<zone_mix>(1 + rng() % 3);
+  if (f == corpus_format::date_only || z == zone_mix::usual)
+    return;
+  if (z == zone_mix::utc) {
+    static const char* const utc[] = { " GMT", " GMT", " +0000", " UTC", "Z", "Z", "", "" };
+    std::strcpy(suffix, utc[static_cast<int>(f)]);
+  } else if (z == zone_mix::offsets) {
+    zone = (static_cast<int>(rng() % 49) - 24) * 1800;
+    const int m = (zone < 0 ? -zone : zone) / 60;
+    std::snprintf(suffix, sizeof(suffix), f == corpus_format::iso8601_utc ? "%s%c%02d:%02d" : "%s%c%02d%02d",
+                  attached ? "" : " ", zone < 0 ? '-' : '+', m / 60, m % 60);
+  } else {
+    const char* name = names[rng() % (sizeof(names) / sizeof(names[0]))];
+    datetimelite::zone_registry::instance().find(name, std::strlen(name), zone);
+    std::snprintf(suffix, sizeof(suffix), " %s", name);
+  }
+}
+
+// n rows as opt says, drawn from seed.
+static corpus
+generate_corpus(const corpus_options& opt, std::size_t n, uint64_t seed)
+{
+  struct row {
+    int64_t t;
+    corpus_format f;
+  };
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> share(0, 1);
+  std::vector<row> rows(n);
+  for (row& r : rows) {
+    r.f = opt.formats.empty() || share(rng) < opt.invalid_share
+      ? corpus_format::invalid : opt.formats[rng() % opt.formats.size()];
+    int64_t lo, hi;
+    epoch_range(r.f, lo, hi);
+    r.t = std::uniform_int_distribution<int64_t>(lo, hi)(rng);
+  }
+  if (opt.sorted)
+    std::stable_sort(rows.begin(), rows.end(), [](const row& a, const row& b) { return a.t < b.t; });
+
+  corpus c;
+  char buf[64];
+  for (const row& r : rows) {
+    std::size_t len;
+    if (r.f == corpus_format::invalid) {
+      len = write_invalid(buf, sizeof(buf), r.t, rng);
+    } else {
+      char suffix[12];
+      int zone;
+      draw_zone(r.f, opt.zones, rng, suffix, zone);
+      const int digits = opt.min_fraction + static_cast<int>(rng() % (opt.max_fraction - opt.min_fraction + 1));
+      const int nsec = static_cast<int>(rng() % 1000000000);
+      if (opt.zones == zone_mix::usual && r.f == corpus_format::clf)
+        zone = (static_cast<int>(rng() % 49) - 24) * 1800;
+      len = write_timestamp(buf, sizeof(buf), r.f, r.t, nsec, zone,
+                            suffix[0] || opt.zones != zone_mix::usual ? suffix : nullptr, digits);
+    }
+    c.push_back(buf, len);
+  }
+  return c;
+}
+
+// A corpus on disk is either text, one timestamp per line, or, from
+// save_corpus with binary set, the corpus itself: the magic below, the
+// row count and the byte count of data as 64-bit integers, offsets as
+// 32-bit ones, then data. Numbers are in the byte order of the machine.
+static const char corpus_magic[8] = { 'D', 'T', 'L', 'C', 'O', 'R', 'P', '1' };
+
+// Writes c to path. On failure returns false with errno set.
+static bool
+save_corpus(const corpus& c, const char* path, bool binary)
+{
+  std::FILE* out = std::fopen(path, "wb");
+  if (!out)
+    return false;
+  bool ok = true;
+  if (binary) {
+    const uint64_t head[2] = { c.size(), c.data.size() };
+    ok = std::fwrite(corpus_magic, sizeof(corpus_magic), 1, out) == 1
+      && std::fwrite(head, sizeof(head), 1, out) == 1
+      && std::fwrite(c.offsets.data(), sizeof(uint32_t), c.offsets.size(), out) == c.offsets.size()
+      && std::fwrite(c.data.data(), 1, c.data.size(), out) == c.data.size();
+  } else {
+    for (std::size_t i = 0; ok && i < c.size(); ++i)
+      ok = std::fwrite(c.c_str(i), 1, c.length(i), out) == c.length(i) && std::fputc('\n', out) != EOF;
+  }
+  const int saved = errno;
+  if (std::fclose(out) != 0)
+    ok = false;
+  else if (!ok)
+    errno = saved ? saved : EIO;
+  return ok;
+}
+
+// Reads what save_corpus wrote, telling the two kinds apart by the
+// magic; text lines may end in CRLF. On failure returns false with
+// errno set, to EINVAL for a binary file that does not add up.
+static bool
+load_corpus(const char* path, corpus& c)
+{
+  std::FILE* in = std::fopen(path, "rb");
+  if (!in)
+    return false;
+  std::string bytes;
+  char chunk[65536];
+  std::size_t got;
+  while ((got = std::fread(chunk, 1, sizeof(chunk), in)) > 0)
+    bytes.append(chunk, got);
+  const bool read_error = std::ferror(in);
+  std::fclose(in);
+  if (read_error) {
+    errno = EIO;
+    return false;
+  }
+
+  c = corpus();
+  const std::size_t head = sizeof(corpus_magic) + 2 * sizeof(uint64_t);
+  if (bytes.size() >= head && std::memcmp(bytes.data(), corpus_magic, sizeof(corpus_magic)) == 0) {
+    uint64_t n[2];
+    std::memcpy(n, bytes.data() + sizeof(corpus_magic), sizeof(n));
+    if (n[0] >= bytes.size() || n[1] > bytes.size() || bytes.size() != head + (n[0] + 1) * sizeof(uint32_t) + n[1]) {
+      errno = EINVAL;
+      return false;
+    }
+    c.offsets.resize(n[0] + 1);
+    std::memcpy(c.offsets.data(), bytes.data() + head, c.offsets.size() * sizeof(uint32_t));
+    c.data.assign(bytes, head + c.offsets.size() * sizeof(uint32_t), n[1]);
+    // offsets must rise from 0 to the end of data, each string ending in a NUL
+    bool ok = c.offsets.front() == 0 && c.offsets.back() == c.data.size();
+    for (std::size_t i = 0; ok && i < c.size(); ++i)
+      ok = c.offsets[i] < c.offsets[i + 1] && c.offsets[i + 1] <= c.data.size()
+        && c.data[c.offsets[i + 1] - 1] == '\0';
+    if (!ok) {
+      c = corpus();
+      errno = EINVAL;
+    }
+    return ok;
+  }
+
+  std::size_t at = 0;
+  while (at < bytes.size()) {
+    std::size_t end = bytes.find('\n', at);
+    const std::size_t next = end == std::string::npos ? bytes.size() : end + 1;
+    if (end == std::string::npos)
+      end = bytes.size();
+    if (end > at && bytes[end - 1] == '\r')
+      --end;
+    c.push_back(bytes.data() + at, end - at);
+    at = next;
+  }
+  return true;
+}
+
+}  // end of namespace bench
+
+#endif
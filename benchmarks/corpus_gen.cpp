@@ -0,0 +1,108 @@
+// Writes a corpus of synthetic timestamps to a file, the same for the
+// same options and seed, for datetime_bench --input, counter_bench
+// --input and anything else that wants the data the benchmarks use.
+//
+//   corpus_gen [--rows N] [--seed S] [--formats NAME,...] [--invalid SHARE]
+//              [--zones usual|utc|offsets|names|mixed] [--fraction MIN[-MAX]]
+//              [--sorted] [--binary] OUTPUT
+//
+// Without --binary, OUTPUT has one timestamp per line.
+
+#include "corpus.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+void
+usage()
+{
+  std::fprintf(stderr, "usage: corpus_gen [--rows N] [--seed S] [--formats NAME,...] [--invalid SHARE]\n"
+               "                  [--zones usual|utc|offsets|names|mixed] [--fraction MIN[-MAX]]\n"
+               "                  [--sorted] [--binary] OUTPUT\n");
+  std::exit(2);
+}
+
+// "http,clf" into formats.
+bool
+parse_formats(const std::string& list, std::vector<bench::corpus_format>& formats)
+{
+  formats.clear();
+  std::size_t at = 0;
+  for (;;) {
+    const std::size_t comma = list.find(',', at);
+    bench::corpus_format f;
+    if (!bench::format_from_name(std::string_view(list).substr(at, comma - at), f))
+      return false;
+    formats.push_back(f);
+    if (comma == std::string::npos)
+      return true;
+    at = comma + 1;
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::size_t rows = 1000000;
+  uint64_t seed = 1;
+  bool binary = false;
+  const char* output = nullptr;
+  bench::corpus_options opt;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "--sorted") {
+      opt.sorted = true;
+      continue;
+    }
+    if (arg == "--binary") {
+      binary = true;
+      continue;
+    }
+    if (arg[0] != '-') {
+      if (output)
+        usage();
+      output = argv[i];
+      continue;
+    }
+    if (i + 1 >= argc)
+      usage();
+    const char* value = argv[++i];
+    if (arg == "--rows")
+      rows = std::strtoull(value, nullptr, 10);
+    else if (arg == "--seed")
+      seed = std::strtoull(value, nullptr, 10);
+    else if (arg == "--invalid")
+      opt.invalid_share = std::atof(value);
+    else if (arg == "--formats") {
+      if (!parse_formats(value, opt.formats))
+        usage();
+    } else if (arg == "--zones") {
+      if (!bench::zone_mix_from_name(value, opt.zones))
+        usage();
+    } else if (arg == "--fraction") {
+      char* end;
+      opt.min_fraction = opt.max_fraction = static_cast<int>(std::strtol(value, &end, 10));
+      if (*end == '-')
+        opt.max_fraction = static_cast<int>(std::strtol(end + 1, &end, 10));
+      if (*end || opt.min_fraction < 0 || opt.max_fraction > 9 || opt.min_fraction > opt.max_fraction)
+        usage();
+    } else
+      usage();
+  }
+  if (!output || rows == 0 || opt.invalid_share < 0 || opt.invalid_share > 1)
+    usage();
+
+  const bench::corpus c = bench::generate_corpus(opt, rows, seed);
+  if (c.data.size() > UINT32_MAX) {
+    std::fprintf(stderr, "corpus_gen: %zu bytes do not fit 32-bit offsets\n", c.data.size());
+    return 1;
+  }
+  if (!bench::save_corpus(c, output, binary)) {
+    std::perror(output);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Cycles, instructions, branch misses and L1d misses per call of
+// datetimelite::time_from_string, for each layout of the corpus, as
+// JSON. Counters the system doesn't give are null; the CPU time per
+// parse is always there.
+//
+//   counter_bench [--rows N] [--seed S] [--min-time SECONDS]
+//                 [--format NAME] [--input CORPUS] [--api tm|epoch]
+//
+// --input counts on a file of corpus_gen instead of the layouts.
+
+#include "datetimelite.h"
+#include "corpus.h"
+#include "perf_counters.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile int64_t sink;
+
+int64_t
+pass_tm(const bench::corpus& c)
+{
+  int64_t acc = 0;
+  for (std::size_t i = 0; i < c.size(); ++i) {
+    try {
+      acc += datetimelite::time_from_string(c.c_str(i), c.length(i)).tm_sec;
+    } catch (const std::invalid_argument&) {
+      --acc;
+    }
+  }
+  return acc;
+}
+
+int64_t
+pass_epoch(const bench::corpus& c)
+{
+  int64_t acc = 0;
+  for (std::size_t i = 0; i < c.size(); ++i) {
+    int64_t sec = 0;
+    datetimelite::parse_error err;
+    acc += datetimelite::try_parse_epoch(c.c_str(i), c.length(i), sec, err) ? sec : -1;
+  }
+  return acc;
+}
+
+void
+usage()
+{
+  std::fprintf(stderr, "usage: counter_bench [--rows N] [--seed S] [--min-time SECONDS] "
+               "[--format NAME] [--input CORPUS] [--api tm|epoch]\n");
+  std::exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::size_t rows = 100000;
+  uint64_t seed = 1;
+  double min_time = 0.2;
+  bool epoch = false;
+  const char* input = nullptr;
+  std::vector<bench::corpus_format> formats(std::begin(bench::all_formats), std::end(bench::all_formats));
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc)
+      usage();
+    if (arg == "--rows")
+      rows = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--seed")
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--min-time")
+      min_time = std::atof(argv[++i]);
+    else if (arg == "--input")
+      input = argv[++i];
+    else if (arg == "--api")
+      epoch = std::string(argv[++i]) == "epoch";
+    else if (arg == "--format") {
+      formats.resize(1);
+      if (!bench::format_from_name(argv[++i], formats[0]))
+        usage();
+    } else
+      usage();
+  }
+  if (rows == 0)
+    usage();
+
+  bench::corpus file;
+  if (input) {
+    if (!bench::load_corpus(input, file)) {
+      std::perror(input);
+      return 1;
+    }
+    if (file.size() == 0)
+      usage();
+    rows = file.size();
+    formats.resize(1);
+  }
+
+  bench::perf_counters pc;
+  std::printf("{\n  \"benchmark\": \"counter_bench\",\n  \"api\": \"%s\",\n  \"rows\": %zu,\n"
+              "  \"seed\": %llu,\n  \"counters\": \"%s\",\n  \"clock\": \"%s\",\n  \"results\": [\n",
+              epoch ? "datetimelite::try_parse_epoch" : "datetimelite::time_from_string",
+              rows, static_cast<unsigned long long>(seed), pc.hardware() ? "hardware" : "none",
+              pc.clock_source());
+  for (std::size_t f = 0; f < formats.size(); ++f) {
+    const bench::corpus c = input ? file : bench::make_corpus(formats[f], rows, seed);
+    int64_t acc = epoch ? pass_epoch(c) : pass_tm(c);  // warm up
+    std::size_t parses = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    pc.start();
+    do {
+      acc += epoch ? pass_epoch(c) : pass_tm(c);
+      parses += c.size();
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < min_time);
+    pc.stop();
+    sink = acc;
+
+    std::printf("    {\"format\": \"%s\", \"parses\": %zu, \"ns_per_parse\": %.2f, \"cpu_ns_per_parse\": %.2f",
+                input ? "input" : bench::format_name(formats[f]), parses, elapsed.count() * 1e9 / parses, pc.cpu_ns() / parses);
+    for (int k = 0; k < bench::counter_count; ++k) {
+      const bench::counter ctr = static_cast<bench::counter>(k);
+      if (pc.available(ctr))
+        std::printf(", \"%s\": %.2f", bench::counter_name(ctr), pc.value(ctr) / parses);
+      else
+        std::printf(", \"%s\": null", bench::counter_name(ctr));
+    }
+    std::printf("}%s\n", f + 1 < formats.size() ? "," : "");
+  }
+  std::printf("  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,319 @@
+// ns/parse and MB/s of datetimelite and of the parsers people replace
+// it with, for each layout of the README, written as JSON.
+//
+//   datetime_bench [--rows N] [--seed S] [--min-time SECONDS]
+//                  [--format NAME] [--input CORPUS] [--json FILE]
+//
+// --input times the datetimelite parsers on a file of corpus_gen
+// instead of the generated layouts.
+// With --json the JSON goes to FILE and a table to stdout, otherwise
+// the JSON goes to stdout.
+
+#include "datetimelite.h"
+#include "datetimelite2.h"
+#include "corpus.h"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Keeps the parsers' results alive.
+volatile int64_t sink;
+
+struct result {
+  std::string format;
+  std::string parser;
+  std::size_t inputs;
+  std::size_t parsed;
+  double ns_per_parse;
+  double mb_per_s;
+};
+
+// One parser: returns whether input i of c parsed, adding something of
+// the result to acc.
+typedef bool (*parse_fn)(const bench::corpus& c, std::size_t i, int64_t& acc);
+
+bool
+datetimelite_tm(const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  try {
+    const struct std::tm tm = datetimelite::time_from_string(c.c_str(i), c.length(i));
+    acc += tm.tm_sec + tm.tm_mday;
+    return true;
+  } catch (const std::invalid_argument&) {
+    return false;
+  }
+}
+
+bool
+datetimelite_epoch(const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  int64_t sec;
+  datetimelite::parse_error err;
+  if (!datetimelite::try_parse_epoch(c.c_str(i), c.length(i), sec, err))
+    return false;
+  acc += sec;
+  return true;
+}
+
+bool
+datetimelite2_ptime(const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  const boost::optional<boost::posix_time::ptime> t = datetimelite2::time_from_string(c.c_str(i), c.length(i));
+  if (!t)
+    return false;
+  acc += t->time_of_day().seconds();
+  return true;
+}
+
+// strptime with the layout's format, then timegm and the parsed offset.
+bool
+strptime_timegm(const char* fmt, const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  struct std::tm tm;
+  std::memset(&tm, 0, sizeof(tm));
+  const char* end = strptime(c.c_str(i), fmt, &tm);
+  if (!end || *end)
+    return false;
+  const long gmtoff = tm.tm_gmtoff;  // timegm clears it
+  acc += static_cast<int64_t>(timegm(&tm)) - gmtoff;
+  return true;
+}
+
+#define STRPTIME(name, fmt) \
+  bool name(const bench::corpus& c, std::size_t i, int64_t& acc) { return strptime_timegm(fmt, c, i, acc); }
+STRPTIME(strptime_http, "%a, %d %b %Y %H:%M:%S GMT")
+STRPTIME(strptime_rfc850, "%A, %d-%b-%y %H:%M:%S GMT")
+STRPTIME(strptime_clf, "%d/%b/%Y:%H:%M:%S %z")
+STRPTIME(strptime_iso8601, "%Y-%m-%d %H:%M:%S")
+STRPTIME(strptime_compact, "%Y%m%dT%H%M%S")
+STRPTIME(strptime_date_only, "%Y-%m-%d")
+#undef STRPTIME
+
+bool
+strptime_iso8601_utc(const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  // strptime has no fraction; it is skipped up to the Z
+  struct std::tm tm;
+  std::memset(&tm, 0, sizeof(tm));
+  const char* end = strptime(c.c_str(i), "%Y-%m-%dT%H:%M:%S", &tm);
+  if (!end || (*end == '.' && !(end = std::strchr(end, 'Z'))) || std::strcmp(end, "Z") != 0)
+    return false;
+  acc += timegm(&tm);
+  return true;
+}
+
+bool
+boost_time_from_string(const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  try {
+    acc += boost::posix_time::time_from_string(c.c_str(i)).time_of_day().seconds();
+    return true;
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+bool
+boost_from_iso_string(const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  try {
+    acc += boost::posix_time::from_iso_string(c.c_str(i)).time_of_day().seconds();
+    return true;
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+bool
+boost_from_simple_string(const bench::corpus& c, std::size_t i, int64_t& acc)
+{
+  try {
+    acc += boost::gregorian::from_simple_string(c.c_str(i)).day();
+    return true;
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+struct parser {
+  const char* name;
+  parse_fn fn;
+};
+
+// The parsers to compare on format f: datetimelite's, strptime with the
+// layout's format string, and boost's where it has one for the layout.
+std::vector<parser>
+parsers_for(bench::corpus_format f)
+{
+  std::vector<parser> p = {
+    { "datetimelite::time_from_string", datetimelite_tm },
+    { "datetimelite::try_parse_epoch", datetimelite_epoch },
+    { "datetimelite2::time_from_string", datetimelite2_ptime },
+  };
+  switch (f) {
+  case bench::corpus_format::http:
+    p.push_back({ "strptime+timegm", strptime_http });
+    break;
+  case bench::corpus_format::rfc850:
+    p.push_back({ "strptime+timegm", strptime_rfc850 });
+    break;
+  case bench::corpus_format::clf:
+    p.push_back({ "strptime+timegm", strptime_clf });
+    break;
+  case bench::corpus_format::iso8601:
+  case bench::corpus_format::invalid:
+    p.push_back({ "strptime+timegm", strptime_iso8601 });
+    p.push_back({ "boost::posix_time::time_from_string", boost_time_from_string });
+    break;
+  case bench::corpus_format::iso8601_utc:
+    p.push_back({ "strptime+timegm", strptime_iso8601_utc });
+    break;
+  case bench::corpus_format::compact:
+    p.push_back({ "strptime+timegm", strptime_compact });
+    p.push_back({ "boost::posix_time::from_iso_string", boost_from_iso_string });
+    break;
+  case bench::corpus_format::date_only:
+    p.push_back({ "strptime+timegm", strptime_date_only });
+    p.push_back({ "boost::gregorian::from_simple_string", boost_from_simple_string });
+    break;
+  }
+  return p;
+}
+
+// Whole passes over the corpus until min_time has gone by, three times;
+// the fastest of the three counts.
+result
+measure(const char* format, const bench::corpus& c, const parser& p, double min_time)
+{
+  result r = { format, p.name, c.size(), 0, 0, 0 };
+  int64_t acc = 0;
+  for (std::size_t i = 0; i < c.size(); ++i)
+    r.parsed += p.fn(c, i, acc);
+  double best = 1e300;
+  for (int trial = 0; trial < 3; ++trial) {
+    std::size_t parses = 0;
+    const auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed(0);
+    do {
+      for (std::size_t i = 0; i < c.size(); ++i)
+        p.fn(c, i, acc);
+      parses += c.size();
+      elapsed = std::chrono::steady_clock::now() - start;
+    } while (elapsed.count() < min_time);
+    best = std::min(best, elapsed.count() / parses);
+  }
+  sink = acc;
+  r.ns_per_parse = best * 1e9;
+  r.mb_per_s = static_cast<double>(c.bytes()) / c.size() / best / 1e6;
+  return r;
+}
+
+void
+write_json(std::FILE* out, const std::vector<result>& results, std::size_t rows, uint64_t seed)
+{
+  std::fprintf(out, "{\n  \"benchmark\": \"datetime_bench\",\n  \"rows\": %zu,\n  \"seed\": %llu,\n  \"results\": [\n",
+               rows, static_cast<unsigned long long>(seed));
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const result& r = results[i];
+    std::fprintf(out, "    {\"format\": \"%s\", \"parser\": \"%s\", \"inputs\": %zu, \"parsed\": %zu, "
+                 "\"ns_per_parse\": %.2f, \"mb_per_s\": %.1f}%s\n",
+                 r.format.c_str(), r.parser.c_str(), r.inputs, r.parsed, r.ns_per_parse, r.mb_per_s,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(out, "  ]\n}\n");
+}
+
+void
+write_table(std::FILE* out, const std::vector<result>& results)
+{
+  std::fprintf(out, "%-12s %-38s %10s %10s %9s\n", "format", "parser", "ns/parse", "MB/s", "parsed%");
+  for (const result& r : results)
+    std::fprintf(out, "%-12s %-38s %10.1f %10.1f %8.1f%%\n", r.format.c_str(), r.parser.c_str(),
+                 r.ns_per_parse, r.mb_per_s, 100.0 * r.parsed / r.inputs);
+}
+
+void
+usage()
+{
+  std::fprintf(stderr, "usage: datetime_bench [--rows N] [--seed S] [--min-time SECONDS] "
+               "[--format NAME] [--input CORPUS] [--json FILE]\n");
+  std::exit(2);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::size_t rows = 100000;
+  uint64_t seed = 1;
+  double min_time = 0.1;
+  const char* json = nullptr;
+  const char* input = nullptr;
+  std::vector<bench::corpus_format> formats(std::begin(bench::all_formats), std::end(bench::all_formats));
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc)
+      usage();
+    if (arg == "--rows")
+      rows = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--seed")
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    else if (arg == "--min-time")
+      min_time = std::atof(argv[++i]);
+    else if (arg == "--json")
+      json = argv[++i];
+    else if (arg == "--input")
+      input = argv[++i];
+    else if (arg == "--format") {
+      formats.resize(1);
+      if (!bench::format_from_name(argv[++i], formats[0]))
+        usage();
+    } else
+      usage();
+  }
+  if (rows == 0)
+    usage();
+
+  std::vector<result> results;
+  if (input) {
+    bench::corpus c;
+    if (!bench::load_corpus(input, c)) {
+      std::perror(input);
+      return 1;
+    }
+    if (c.size() == 0)
+      usage();
+    rows = c.size();
+    for (const parser& p : parsers_for(bench::corpus_format::invalid))
+      if (std::strncmp(p.name, "datetimelite", 12) == 0)
+        results.push_back(measure("input", c, p, min_time));
+  }
+  for (bench::corpus_format f : input ? std::vector<bench::corpus_format>() : formats) {
+    const bench::corpus c = bench::make_corpus(f, rows, seed);
+    for (const parser& p : parsers_for(f))
+      results.push_back(measure(bench::format_name(f), c, p, min_time));
+  }
+
+  if (json) {
+    std::FILE* out = std::fopen(json, "w");
+    if (!out) {
+      std::perror(json);
+      return 1;
+    }
+    write_json(out, results, rows, seed);
+    std::fclose(out);
+    write_table(stdout, results);
+  } else {
+    write_json(stdout, results, rows, seed);
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+// Throughput of parse_batch over an Arrow-style column with 1, 2, 4, ...
+// threads, up to the number of cores or the count given as argv[2].
+//
+//   parallel_bench [rows] [max threads]
+//   parallel_bench --input CORPUS [max threads]
+//
+// --input takes the column from a file of corpus_gen instead of
+// making rows of iso8601_utc.
+
+#include "datetimelite/parallel.h"
+#include "corpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+  const char* input = nullptr;
+  if (argc > 2 && std::strcmp(argv[1], "--input") == 0) {
+    input = argv[2];
+    argv += 1;  // max threads moves to argv[2]
+    argc -= 1;
+  }
+  std::size_t n = !input && argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+  const unsigned max_threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+
+  std::string data;
+  std::vector<int32_t> offsets = { 0 };
+  if (input) {
+    // the corpus without its NULs
+    bench::corpus c;
+    if (!bench::load_corpus(input, c)) {
+      std::perror(input);
+      return 1;
+    }
+    if (c.data.size() > 0x7fffffff) {
+      std::fprintf(stderr, "column too large for int32 offsets\n");
+      return 1;
+    }
+    n = c.size();
+    data.reserve(c.bytes());
+    for (std::size_t i = 0; i < n; ++i) {
+      data.append(c.c_str(i), c.length(i));
+      offsets.push_back(static_cast<int32_t>(data.size()));
+    }
+  }
+  char buf[64];
+  for (std::size_t i = 0; !input && i < n; ++i) {
+    const int64_t t = 946684800 + static_cast<int64_t>(i) * 7919 % 631152000;
+    const int64_t days = t / 86400, s = t % 86400;
+    int y, m, d;
+    datetimelite::civil_from_days(days, y, m, d);
+    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+                  y, m, d, static_cast<int>(s / 3600), static_cast<int>(s / 60 % 60),
+                  static_cast<int>(s % 60), static_cast<int>(i % 1000));
+    data += buf;
+    if (data.size() > 0x7fffffff) {
+      std::fprintf(stderr, "column too large for int32 offsets\n");
+      return 1;
+    }
+    offsets.push_back(static_cast<int32_t>(data.size()));
+  }
+
+  std::vector<int64_t> sec(n);
+  std::vector<int32_t> nsec(n);
+  std::vector<uint8_t> valid((n + 7) / 8);
+  datetimelite::epoch_columns out = { sec.data(), nsec.data(), nullptr, valid.data() };
+
+  std::printf("%zu rows, %.1f MB%s%s\n", n, data.size() / 1e6, input ? " from " : "", input ? input : "");
+  std::printf("%8s %12s %10s %8s\n", "threads", "ns/row", "MB/s", "speedup");
+  double base = 0;
+  std::size_t base_rows = n;
+  for (unsigned threads = 1;; threads = std::min(threads * 2, max_threads)) {
+    datetimelite::thread_pool pool(threads);
+    double best = 1e300;
+    std::size_t valid_rows = 0;
+    for (int run = 0; run < 3; ++run) {
+      const auto start = std::chrono::steady_clock::now();
+      valid_rows = datetimelite::parse_batch(pool, data.data(), offsets.data(), n, out);
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    // a corpus may hold invalid rows, but every thread count must agree
+    if (threads == 1 && input)
+      base_rows = valid_rows;
+    if (valid_rows != base_rows) {
+      std::fprintf(stderr, "%zu of %zu rows failed to parse\n", n - valid_rows, n);
+      return 1;
+    }
+    if (threads == 1)
+      base = best;
+    std::printf("%8u %12.2f %10.1f %8.2f\n", threads, best * 1e9 / n,
+                data.size() / best / 1e6, base / best);
+    if (threads >= max_threads)
+      break;
+  }
+  return 0;
+}
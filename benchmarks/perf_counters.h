@@ -0,0 +1,158 @@
+// Per-thread hardware counters through perf_event_open(2): cycles,
+// instructions, branch misses and L1d read misses. Each one that the
+// kernel, the CPU or the container refuses is left out, and the time
+// comes from the software task clock, or CLOCK_THREAD_CPUTIME_ID if
+// even that is refused.
+
+#ifndef _DATETIMELITE_BENCH_PERF_COUNTERS_H_
+#define _DATETIMELITE_BENCH_PERF_COUNTERS_H_
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bench {
+
+enum counter {
+  cycles,
+  instructions,
+  branch_misses,
+  l1d_misses,
+  counter_count
+};
+
+static const char*
+counter_name(counter c)
+{
+  static const char* const names[] = { "cycles", "instructions", "branch_misses", "l1d_misses" };
+  return names[c];
+}
+
+class perf_counters {
+public:
+  perf_counters()
+  {
+    static const uint64_t l1d_read_miss = PERF_COUNT_HW_CACHE_L1D
+      | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    fd_[cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fd_[instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fd_[branch_misses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+    fd_[l1d_misses] = open(PERF_TYPE_HW_CACHE, l1d_read_miss);
+    clock_fd_ = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+  }
+
+  ~perf_counters()
+  {
+    for (int fd : fd_)
+      if (fd >= 0)
+        ::close(fd);
+    if (clock_fd_ >= 0)
+      ::close(clock_fd_);
+  }
+
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  bool
+  available(counter c) const
+  {
+    return fd_[c] >= 0;
+  }
+
+  // Whether any hardware counter could be opened.
+  bool
+  hardware() const
+  {
+    for (int fd : fd_)
+      if (fd >= 0)
+        return true;
+    return false;
+  }
+
+  // Where the CPU time comes from.
+  const char*
+  clock_source() const
+  {
+    return clock_fd_ >= 0 ? "task-clock" : "thread-cputime";
+  }
+
+  void
+  start()
+  {
+    for (int i = 0; i < counter_count; ++i)
+      begin_[i] = read(fd_[i]);
+    clock_begin_ = cpu_time();
+  }
+
+  void
+  stop()
+  {
+    clock_end_ = cpu_time();
+    for (int i = 0; i < counter_count; ++i)
+      end_[i] = read(fd_[i]);
+  }
+
+  // Count between start() and stop(), scaled up if the kernel had to
+  // multiplex the counter. Meaningless if !available(c).
+  double
+  value(counter c) const
+  {
+    return end_[c] - begin_[c];
+  }
+
+  // CPU time of the thread between start() and stop(), in ns.
+  double
+  cpu_ns() const
+  {
+    return clock_end_ - clock_begin_;
+  }
+
+private:
+  static int
+  open(uint32_t type, uint64_t config)
+  {
+    struct perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  // The running count, extrapolated over the time it was scheduled out.
+  static double
+  read(int fd)
+  {
+    uint64_t v[3];
+    if (fd < 0 || ::read(fd, v, sizeof(v)) != static_cast<ssize_t>(sizeof(v)) || v[2] == 0)
+      return 0;
+    return static_cast<double>(v[0]) * v[1] / v[2];
+  }
+
+  double
+  cpu_time() const
+  {
+    if (clock_fd_ >= 0)
+      return read(clock_fd_);
+    struct timespec ts;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+  }
+
+  int fd_[counter_count];
+  int clock_fd_;
+  double begin_[counter_count] = {};
+  double end_[counter_count] = {};
+  double clock_begin_ = 0;
+  double clock_end_ = 0;
+};
+
+}  // end of namespace bench
+
+#endif
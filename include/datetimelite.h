@@ -25,20 +25,58 @@ THE SOFTWARE.
 #ifndef _DATETIMELITE_H_
 #define _DATETIMELITE_H_
 #include <string>
+#include <string_view>
 #include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
 #include <stdexcept>
+#include <atomic>
+
+// Define DATETIMELITE_MONTH_IGNORE_CASE as 1 to accept month names in
+// any letter case, e.g. "FEB" or "feb".
+#ifndef DATETIMELITE_MONTH_IGNORE_CASE
+#define DATETIMELITE_MONTH_IGNORE_CASE 0
+#endif
+
+// The SSE4.2 and AVX2 kernels are built with per-function target
+// attributes, so the library itself needs no -msse4.2/-mavx2, and one is
+// picked at run time from what the CPU supports. Define
+// DATETIMELITE_KERNEL as one of the values below to force a kernel, for
+// benchmarking; forcing one the CPU lacks is undefined.
+#define DATETIMELITE_KERNEL_SCALAR 1
+#define DATETIMELITE_KERNEL_SSE42 2
+#define DATETIMELITE_KERNEL_AVX2 3
+
+#if !defined(DATETIMELITE_NO_SIMD) && defined(__GNUC__) \
+  && (defined(__x86_64__) || defined(__i386__))
+#define DATETIMELITE_X86_KERNELS 1
+#define DATETIMELITE_TARGET(isa) __attribute__((target(isa)))
+#include <immintrin.h>
+#endif
 
 #define HANDLE_EXCEPTION(msg) \
   throw std::invalid_argument(msg)
 
+#define HANDLE_ERROR_AT(code, p) \
+  do { \
+    err.status = (code); \
+    err.offset = (p) - s; \
+    return false; \
+  } while (0)
+
+#define HANDLE_ERROR(code) \
+  HANDLE_ERROR_AT(code, c)
+
+#define PEEK(c) \
+  ((c) < end ? *(c) : '\0')
+
 #define SET_V(n) \
-    std::memcpy(buf, c - n, 4); \
-    buf[n] = '\0'; \
-    v = std::atoi(buf)
+    v = detail::digits_value(c - n, n)
 
 #define STEP_RANGE(c, i1, i2) \
-  if (!(*c >= i1 && *c <= i2)) \
-    HANDLE_EXCEPTION("format not supported: wrong range"); \
+  if (!(PEEK(c) >= i1 && PEEK(c) <= i2)) \
+    HANDLE_ERROR(parse_status::out_of_range); \
   ++c
 
 #define IS_DIGIT(c) \
@@ -51,43 +89,84 @@ THE SOFTWARE.
     (((c) >= 'a' && (c) <= 'z') || ((c) >= 'A' && (c) <= 'Z'))
 
 #define STEP_DIGIT(c) \
-  if (!IS_DIGIT(*c)) \
-    HANDLE_EXCEPTION("format not supported: should be digit"); \
+  if (!IS_DIGIT(PEEK(c))) \
+    HANDLE_ERROR(parse_status::expected_digit); \
   ++c
 
 #define STEP_DELIMITER(c) \
-    if (!(*c == ' ' || *c == '-' || *c == '/')) \
-      HANDLE_EXCEPTION("format not supported: delimiter not found"); \
+    if (!(PEEK(c) == ' ' || PEEK(c) == '-' || PEEK(c) == '/')) \
+      HANDLE_ERROR(parse_status::expected_delimiter); \
     ++c
 
 #define STEP_IF_DELIMITER(c) \
-  if (*c == ' ' || *c == '-' || *c == '/') \
+  if (PEEK(c) == ' ' || PEEK(c) == '-' || PEEK(c) == '/') \
     ++c
 
-#define RETURN_TYPE struct std::tm
+namespace datetimelite {
 
-#define WRAP_RESULT(ts) ts
+enum class parse_status {
+  ok = 0,
+  too_short,
+  bad_weekday,
+  expected_digit,
+  expected_delimiter,
+  out_of_range,
+  bad_year,
+  bad_month,
+  bad_mday,
+  invalid_date,
+  bad_hour,
+  bad_minute,
+  bad_second,
+  bad_zone,
+  unknown_zone
+};
 
-namespace datetimelite {
+// Why and where try_parse stopped. offset is the byte offset into the
+// input of the offending field.
+struct parse_error {
+  parse_status status;
+  std::size_t offset;
 
-static bool
+  const char* what() const
+  {
+    static const char* const messages[] = {
+      "ok",
+      "format not supported: too short",
+      "format not supported: weekday sepratator",
+      "format not supported: should be digit",
+      "format not supported: delimiter not found",
+      "format not supported: wrong range",
+      "format not supported: wrong year",
+      "format not supported: wrong month",
+      "format not supported: wrong mday",
+      "format not supported: invalid datetime",
+      "format not supported: hour is too big",
+      "format not supported: wrong minute",
+      "format not supported: wrong second",
+      "format not supported: wrong timezone",
+      "format not supported: unknown timezone"
+    };
+    return messages[static_cast<int>(status)];
+  }
+};
+
+static constexpr bool
 is_leap_year(unsigned short year)
 {
-  return (year % 400 == 0) || ((year % 4 == 0) && (year % 100 != 0));
+  return (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0);
 }
 
-static int
+// 31 for the odd months up to July and the even ones from August.
+static constexpr int
 days_in_month(unsigned short year, unsigned short month)
 {
-  static const unsigned short table[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
-  if ( month == 0 || month > 12 )
-    return 0;
-  if ( month == 2 && is_leap_year(year))
-    return 29;
-  return table[month-1];
+  return (month == 0 || month > 12) ? 0
+    : month == 2 ? 28 + is_leap_year(year)
+    : 30 + ((month ^ (month >> 3)) & 1);
 }
 
-static bool
+static constexpr bool
 check_date(unsigned short year, unsigned short month, unsigned short mday)
 {
   return ((month > 0)
@@ -96,244 +175,1255 @@ check_date(unsigned short year, unsigned short month, unsigned short mday)
     && (mday <= days_in_month(year, month)));
 }
 
-static RETURN_TYPE
-time_from_string(const std::string& s)
+// Days between 1970-01-01 and a date of the proleptic Gregorian
+// calendar, and back: H. Hinnant's era arithmetic. The year is moved
+// into the non-negative by a whole number of 400 year eras first, so
+// every division is of a non-negative value and there is no branch on
+// the sign. Exact for every year an int holds.
+static constexpr int64_t civil_era_bias = 5368710;  // eras, 2^31 years / 400 rounded up
+
+static constexpr int64_t
+days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+  const uint64_t yp = static_cast<uint64_t>(y - (m <= 2) + civil_era_bias * 400);
+  const uint64_t era = yp / 400;
+  const unsigned yoe = static_cast<unsigned>(yp - era * 400);
+  const unsigned doy = (153 * ((m + 9) % 12) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return static_cast<int64_t>(era * 146097 + doe) - 719468 - civil_era_bias * 146097;
+}
+
+static constexpr void
+civil_from_days(int64_t z, int& y, int& m, int& d)
+{
+  const uint64_t zp = static_cast<uint64_t>(z + 719468 + civil_era_bias * 146097);
+  const uint64_t era = zp / 146097;
+  const unsigned doe = static_cast<unsigned>(zp - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+  m = static_cast<int>((mp + 2) % 12 + 1);
+  y = static_cast<int>(static_cast<int64_t>(era * 400 + yoe) - civil_era_bias * 400 + (m <= 2));
+}
+
+// Date and time as written in the input. The wall clock fields are not
+// adjusted by the zone; utc_offset holds it in seconds east of UTC.
+// year is the full year and mon is 1-12.
+struct datetime {
+  int year;
+  int mon;
+  int mday;
+  int hour;
+  int min;
+  int sec;
+  int nsec;
+  int utc_offset;
+};
+
+// Timezone abbreviations the parser accepts, and their offsets. It
+// starts with those of RFC 822 (UT, GMT, the US zones and the military
+// letters) plus UTC, and more can be added at any time:
+//
+//   zone_registry::instance().add("JST", 9 * 3600);
+//
+// Entries live in a fixed open addressing table. Each slot is one
+// atomic word holding the name (up to 6 bytes) and the offset in
+// minutes, so a lookup is usually one hash and one load, and add() may
+// run concurrently with parsing.
+class zone_registry {
+public:
+  static zone_registry& instance()
+  {
+    static zone_registry registry;
+    return registry;
+  }
+
+  // Adds name, or replaces its offset. offset is in seconds east of UTC
+  // and must be whole minutes within a day. Returns false for a name
+  // that is empty, longer than 6 bytes or holds a NUL, for a bad
+  // offset, or if the table is full.
+  bool add(std::string_view name, int offset)
+  {
+    uint64_t key;
+    if (!pack(name.data(), name.size(), key)
+        || offset % 60 != 0 || offset < -86400 || offset > 86400)
+      return false;
+    const uint64_t entry = (key << 16) | static_cast<uint16_t>(offset / 60);
+    std::size_t slot = hash(key);
+    for (std::size_t i = 0; i < capacity; ++i, slot = (slot + 1) & (capacity - 1)) {
+      uint64_t current = slots_[slot].load(std::memory_order_acquire);
+      while (current == 0 || (current >> 16) == key) {
+        if (slots_[slot].compare_exchange_weak(current, entry,
+              std::memory_order_release, std::memory_order_acquire))
+          return true;
+      }
+    }
+    return false;
+  }
+
+  // Offset in seconds east of UTC of the n byte name at p.
+  bool find(const char* p, std::size_t n, int& offset) const
+  {
+    uint64_t key;
+    if (!pack(p, n, key))
+      return false;
+    std::size_t slot = hash(key);
+    for (std::size_t i = 0; i < capacity; ++i, slot = (slot + 1) & (capacity - 1)) {
+      uint64_t current = slots_[slot].load(std::memory_order_acquire);
+      if (current == 0)
+        return false;
+      if ((current >> 16) == key) {
+        offset = static_cast<int16_t>(current & 0xFFFF) * 60;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool find(std::string_view name, int& offset) const
+  {
+    return find(name.data(), name.size(), offset);
+  }
+
+private:
+  static const std::size_t capacity = 256;
+
+  zone_registry()
+  {
+    for (std::size_t i = 0; i < capacity; ++i)
+      slots_[i].store(0, std::memory_order_relaxed);
+    static const struct {
+      const char* name;
+      int hours;
+    } defaults[] = {
+      { "UT", 0 }, { "UTC", 0 }, { "GMT", 0 }, { "Z", 0 },
+      { "EST", -5 }, { "EDT", -4 }, { "CST", -6 }, { "CDT", -5 },
+      { "MST", -7 }, { "MDT", -6 }, { "PST", -8 }, { "PDT", -7 },
+      { "A", 1 }, { "B", 2 }, { "C", 3 }, { "D", 4 }, { "E", 5 }, { "F", 6 },
+      { "G", 7 }, { "H", 8 }, { "I", 9 }, { "K", 10 }, { "L", 11 }, { "M", 12 },
+      { "N", -1 }, { "O", -2 }, { "P", -3 }, { "Q", -4 }, { "R", -5 }, { "S", -6 },
+      { "T", -7 }, { "U", -8 }, { "V", -9 }, { "W", -10 }, { "X", -11 }, { "Y", -12 },
+    };
+    for (std::size_t i = 0; i < sizeof(defaults) / sizeof(defaults[0]); ++i)
+      add(defaults[i].name, defaults[i].hours * 3600);
+  }
+
+  zone_registry(const zone_registry&) = delete;
+  zone_registry& operator=(const zone_registry&) = delete;
+
+  static bool pack(const char* p, std::size_t n, uint64_t& key)
+  {
+    if (n == 0 || n > 6)
+      return false;
+    key = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      if (p[i] == '\0')
+        return false;
+      key |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    }
+    return true;
+  }
+
+  static std::size_t hash(uint64_t key)
+  {
+    return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 56);
+  }
+
+  std::atomic<uint64_t> slots_[capacity];
+};
+
+namespace detail {
+
+// Value of n digits at p, the digits already checked.
+static int
+digits_value(const char* p, int n)
+{
+  int v = 0;
+  for (int i = 0; i < n; ++i)
+    v = v * 10 + (p[i] - '0');
+  return v;
+}
+
+// The SWAR helpers below work on eight characters held in one 64 bit
+// word, the first character in the lowest byte.
+static uint64_t
+load8(const char* p)
+{
+  uint64_t w;
+  std::memcpy(&w, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  w = __builtin_bswap64(w);
+#endif
+  return w;
+}
+
+// True if all eight bytes are '0'-'9'. A byte passes only if its high
+// nibble is 3 and adding 6 doesn't carry out of the low nibble.
+static bool
+all_digits8(uint64_t w)
+{
+  return ((w & 0xF0F0F0F0F0F0F0F0ULL)
+    | (((w + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+    == 0x3333333333333333ULL;
+}
+
+// Eight digits to four two-digit values, one in each 16 bit lane:
+// "19940203" gives 19, 94, 2, 3 from the lowest lane up.
+static uint64_t
+digit_pairs8(uint64_t w)
+{
+  w -= 0x3030303030303030ULL;
+  return ((w * (1 + (10 << 8))) >> 8) & 0x00FF00FF00FF00FFULL;
+}
+
+// Eight digits to their value, "12345678" gives 12345678.
+static uint32_t
+digits8_value(uint64_t w)
+{
+  w = digit_pairs8(w);
+  w = ((w * (1 + (100ULL << 16))) >> 16) & 0x0000FFFF0000FFFFULL;
+  return static_cast<uint32_t>((w * (1 + (10000ULL << 32))) >> 32);
+}
+
+static int
+lane(uint64_t pairs, int i)
+{
+  return static_cast<int>((pairs >> (16 * i)) & 0xFF);
+}
+
+// "YYYY-MM-DD" at p (ten bytes) as the word "YYYYMMDD".
+static uint64_t
+squeeze_date(const char* p)
+{
+  uint64_t w = load8(p);
+  return (w & 0x00000000FFFFFFFFULL)
+    | ((w >> 8) & 0x0000FFFF00000000ULL)
+    | (static_cast<uint64_t>(static_cast<unsigned char>(p[8])) << 48)
+    | (static_cast<uint64_t>(static_cast<unsigned char>(p[9])) << 56);
+}
+
+// "HH:MM:SS" at p (eight bytes) as the word "HHMMSS00".
+static uint64_t
+squeeze_time(const char* p)
+{
+  uint64_t w = load8(p);
+  return (w & 0x000000000000FFFFULL)
+    | ((w >> 8) & 0x00000000FFFF0000ULL)
+    | ((w >> 16) & 0x0000FFFF00000000ULL)
+    | 0x3030000000000000ULL;
+}
+
+// "YYYY-MM-DD" or "YYYYMMDD" at p, decoded as one word. Returns false,
+// leaving c alone, for any other shape or a field out of range, so the
+// caller can fall back to reading byte by byte.
+static bool
+parse_date8(const char* p, const char* end, datetime& f, const char*& c)
+{
+  uint64_t w;
+  int span;
+  if (end - p >= 10 && p[4] == '-' && p[7] == '-') {
+    w = squeeze_date(p);
+    span = 10;
+  } else if (end - p >= 8) {
+    w = load8(p);
+    span = 8;
+  } else {
+    return false;
+  }
+  if (!all_digits8(w))
+    return false;
+  uint64_t pairs = digit_pairs8(w);
+  int year = lane(pairs, 0) * 100 + lane(pairs, 1);
+  int mon = lane(pairs, 2);
+  int mday = lane(pairs, 3);
+  if (year < 1900 || mon == 0 || mon > 12 || mday == 0 || mday > 31)
+    return false;
+  f.year = year;
+  f.mon = mon;
+  f.mday = mday;
+  c = p + span;
+  return true;
+}
+
+// "HH:MM:SS" or "HHMMSS" at p, the same way as parse_date8.
+static bool
+parse_time8(const char* p, const char* end, datetime& f, const char*& c)
+{
+  uint64_t w;
+  int span;
+  if (end - p >= 8 && p[2] == ':' && p[5] == ':') {
+    w = squeeze_time(p);
+    span = 8;
+  } else if (end - p >= 6) {
+    w = 0x3030303030303030ULL;
+    std::memcpy(&w, p, 6);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    span = 6;
+  } else {
+    return false;
+  }
+  if (!all_digits8(w))
+    return false;
+  uint64_t pairs = digit_pairs8(w);
+  int hour = lane(pairs, 0);
+  int min = lane(pairs, 1);
+  int sec = lane(pairs, 2);
+  if (hour > 24 || min > 59 || sec > 61)
+    return false;
+  f.hour = hour;
+  f.min = min;
+  f.sec = sec;
+  c = p + span;
+  return true;
+}
+
+// Reads the first n (at most 9) fraction digits as nanoseconds. The
+// digits are copied over "000000000" and always converted as nine,
+// eight of them in one word, whatever the precision of the input.
+static int
+parse_fraction(const char* p, std::size_t n)
+{
+  char digits[9] = { '0', '0', '0', '0', '0', '0', '0', '0', '0' };
+  std::memcpy(digits, p, n < 9 ? n : 9);
+  return static_cast<int>(digits8_value(load8(digits))) * 10 + (digits[8] - '0');
+}
+
+// The canonical ISO8601 layout in UTC, "YYYY-MM-DDTHH:MM:SSZ" with an
+// optional fraction of 1-9 digits before the Z, is 20 to 30 bytes long
+// and is checked and converted as a whole by one of the kernels below.
+// They expect canonical_candidate to hold and return false for anything
+// else, without reporting why; the caller then runs the general parser,
+// which does.
+static const std::size_t canonical_min = 20;
+static const std::size_t canonical_max = 30;
+
+static bool
+canonical_candidate(const char* s, std::size_t len)
+{
+  return len >= canonical_min && len <= canonical_max && s[len - 1] == 'Z' && len != 21;
+}
+
+// Range checks shared by every kernel, and the assignment.
+static bool
+set_canonical(datetime& dt, int year, int mon, int mday, int hour, int min, int sec,
+              const char* s, std::size_t len)
+{
+  if (year < 1900 || !check_date(year, mon, mday) || hour > 24 || min > 59 || sec > 61)
+    return false;
+  dt.year = year;
+  dt.mon = mon;
+  dt.mday = mday;
+  dt.hour = hour;
+  dt.min = min;
+  dt.sec = sec;
+  dt.nsec = len > canonical_min ? parse_fraction(s + 20, len - 21) : 0;
+  dt.utc_offset = 0;
+  return true;
+}
+
+static bool
+parse_canonical_scalar(const char* s, std::size_t len, datetime& dt)
+{
+  if (s[4] != '-' || s[7] != '-' || s[10] != 'T' || s[13] != ':' || s[16] != ':')
+    return false;
+  if (len > canonical_min) {
+    if (s[19] != '.')
+      return false;
+    for (std::size_t i = 20; i < len - 1; ++i)
+      if (!IS_DIGIT(s[i]))
+        return false;
+  }
+  uint64_t date = squeeze_date(s);
+  uint64_t time = squeeze_time(s + 11);
+  if (!all_digits8(date) || !all_digits8(time))
+    return false;
+  uint64_t d = digit_pairs8(date);
+  uint64_t t = digit_pairs8(time);
+  return set_canonical(dt, lane(d, 0) * 100 + lane(d, 1), lane(d, 2), lane(d, 3),
+                       lane(t, 0), lane(t, 1), lane(t, 2), s, len);
+}
+
+#if defined(DATETIMELITE_X86_KERNELS)
+// Positions of the digits of "YYYY-MM-DDTHH:MM:SS" and its fraction.
+static const uint32_t canonical_digits = 0x6DB6F;
+static const int canonical_fraction_shift = 20;
+
+// Gathers the twelve date and time digits of the first 16 bytes, and the
+// two seconds digits of the next 16, as seven pairs and converts them
+// with one multiply-add: YY YY MM DD hh mm ss, one per 16 bit lane.
+DATETIMELITE_TARGET("sse4.2") static __m128i
+canonical_pairs(__m128i lo, __m128i hi)
+{
+  const __m128i zero = _mm_set1_epi8('0');
+  __m128i a = _mm_shuffle_epi8(lo, _mm_setr_epi8(0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, -1, -1, -1, -1));
+  __m128i b = _mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 2, -1, -1));
+  __m128i digits = _mm_subs_epu8(_mm_or_si128(a, b), zero);
+  return _mm_maddubs_epi16(digits, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 0, 0));
+}
+
+// Checks every pair against its bounds in one compare and hands the
+// lanes to set_canonical for the year and the length of the month.
+DATETIMELITE_TARGET("sse4.2") static bool
+finish_canonical(__m128i pairs, const char* s, std::size_t len, datetime& dt)
+{
+  const __m128i min = _mm_setr_epi16(19, 0, 1, 1, 0, 0, 0, 0);
+  const __m128i max = _mm_setr_epi16(99, 99, 12, 31, 24, 59, 61, 0);
+  __m128i bad = _mm_or_si128(_mm_cmplt_epi16(pairs, min), _mm_cmpgt_epi16(pairs, max));
+  if (_mm_movemask_epi8(bad) != 0)
+    return false;
+  alignas(16) int16_t v[8];
+  _mm_store_si128(reinterpret_cast<__m128i*>(v), pairs);
+  return set_canonical(dt, v[0] * 100 + v[1], v[2], v[3], v[4], v[5], v[6], s, len);
+}
+
+// Loads the len (20 to 30) bytes at s as two registers, the second one
+// zero padded past the end, without reading outside the string: the tail
+// is the last 16 bytes, shifted down into place with one shuffle.
+DATETIMELITE_TARGET("sse4.2") static void
+load_canonical(const char* s, std::size_t len, __m128i& lo, __m128i& hi)
+{
+  const __m128i lane = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  const __m128i index = _mm_add_epi8(lane, _mm_set1_epi8(static_cast<char>(32 - len)));
+  const __m128i inside = _mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(len - 16)), lane);
+  lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+  hi = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + len - 16)),
+                        _mm_or_si128(index, _mm_andnot_si128(inside, _mm_set1_epi8(-1))));
+}
+
+DATETIMELITE_TARGET("sse4.2") static uint32_t
+digit_mask(__m128i x)
+{
+  __m128i t = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(9)), t)));
+}
+
+// Two 16 byte registers. The pair gather relies on SSSE3, which every
+// SSE4.2 processor has.
+DATETIMELITE_TARGET("sse4.2") static bool
+parse_canonical_sse42(const char* s, std::size_t len, datetime& dt)
+{
+  __m128i lo, hi;
+  load_canonical(s, len, lo, hi);
+  const __m128i shape = _mm_setr_epi8(0, 0, 0, 0, '-', 0, 0, '-', 0, 0, 'T', 0, 0, ':', 0, 0);
+  uint32_t digits = digit_mask(lo) | (digit_mask(hi) << 16);
+  uint32_t literals = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, shape)));
+  uint32_t want = canonical_digits;
+  if (len > canonical_min)
+    want |= ((1u << (len - 21)) - 1) << canonical_fraction_shift;
+  if ((digits & want) != want || (literals & 0x2490) != 0x2490 || s[16] != ':'
+      || (len > canonical_min && s[19] != '.'))
+    return false;
+  return finish_canonical(canonical_pairs(lo, hi), s, len, dt);
+}
+
+// The whole string in one 32 byte register: a single digit test and a
+// single literal compare cover every position including the fraction.
+DATETIMELITE_TARGET("avx2") static bool
+parse_canonical_avx2(const char* s, std::size_t len, datetime& dt)
+{
+  __m128i lo, hi;
+  load_canonical(s, len, lo, hi);
+  __m256i x = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+  const __m256i shape = _mm256_setr_epi8(
+    0, 0, 0, 0, '-', 0, 0, '-', 0, 0, 'T', 0, 0, ':', 0, 0,
+    ':', 0, 0, '.', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m256i t = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+  uint32_t digits = static_cast<uint32_t>(_mm256_movemask_epi8(
+    _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(9)), t)));
+  uint32_t literals = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, shape)));
+  uint32_t want = canonical_digits;
+  uint32_t want_literals = 0x12490;
+  if (len > canonical_min) {
+    want |= ((1u << (len - 21)) - 1) << canonical_fraction_shift;
+    want_literals |= 1u << 19;
+  }
+  if ((digits & want) != want || (literals & want_literals) != want_literals)
+    return false;
+  // finish_canonical is SSE code: clear the upper halves before it runs,
+  // or every SSE instruction in it pays the AVX transition penalty
+  _mm256_zeroupper();
+  return finish_canonical(canonical_pairs(lo, hi), s, len, dt);
+}
+#endif
+
+typedef bool (*canonical_kernel)(const char* s, std::size_t len, datetime& dt);
+
+// Runs cpuid once, the first time a canonical string is seen.
+static canonical_kernel
+select_canonical_kernel()
+{
+#if defined(DATETIMELITE_KERNEL) && defined(DATETIMELITE_X86_KERNELS)
+#if DATETIMELITE_KERNEL == DATETIMELITE_KERNEL_AVX2
+  return parse_canonical_avx2;
+#elif DATETIMELITE_KERNEL == DATETIMELITE_KERNEL_SSE42
+  return parse_canonical_sse42;
+#else
+  return parse_canonical_scalar;
+#endif
+#elif defined(DATETIMELITE_X86_KERNELS)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return parse_canonical_avx2;
+  if (__builtin_cpu_supports("sse4.2"))
+    return parse_canonical_sse42;
+  return parse_canonical_scalar;
+#else
+  return parse_canonical_scalar;
+#endif
+}
+
+static canonical_kernel
+canonical_kernel_in_use()
+{
+  static const canonical_kernel kernel = select_canonical_kernel();
+  return kernel;
+}
+
+static bool
+parse_canonical(const char* s, std::size_t len, datetime& dt)
+{
+  if (!canonical_candidate(s, len))
+    return false;
+  return canonical_kernel_in_use()(s, len, dt);
+}
+
+// Three bytes packed into one integer, the first in the lowest byte.
+static constexpr uint32_t
+pack3(char a, char b, char c)
+{
+  return static_cast<unsigned char>(a)
+    | (static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8)
+    | (static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16);
+}
+
+// Month number of a three letter English abbreviation at p, or 0.
+// The key is hashed after folding it to lower case: the multiplier
+// sends each of the twelve months to its own slot of a 16 entry table,
+// so a month costs one load and one compare. With ignore_case, "FEB"
+// and "feb" match as well as "Feb".
+static int
+month_from_name(const char* p, bool ignore_case = DATETIMELITE_MONTH_IGNORE_CASE)
+{
+  static const struct {
+    uint32_t key;
+    int mon;
+  } table[16] = {
+    { 0, 0 },
+    { pack3('O', 'c', 't'), 10 },
+    { pack3('F', 'e', 'b'), 2 },
+    { 0, 0 },
+    { pack3('D', 'e', 'c'), 12 },
+    { pack3('J', 'u', 'l'), 7 },
+    { pack3('N', 'o', 'v'), 11 },
+    { pack3('J', 'a', 'n'), 1 },
+    { pack3('J', 'u', 'n'), 6 },
+    { 0, 0 },
+    { pack3('M', 'a', 'y'), 5 },
+    { pack3('S', 'e', 'p'), 9 },
+    { pack3('A', 'u', 'g'), 8 },
+    { 0, 0 },
+    { pack3('M', 'a', 'r'), 3 },
+    { pack3('A', 'p', 'r'), 4 },
+  };
+  uint32_t key = pack3(p[0], p[1], p[2]);
+  uint32_t folded = key | 0x202020;
+  const uint32_t slot = ((folded * 0x11C) >> 20) & 15;
+  if (ignore_case ? folded == (table[slot].key | 0x202020) : key == table[slot].key)
+    return table[slot].mon;
+  return 0;
+}
+
+// Zone designator from c to the end of input: a numeric offset
+// (+hh:mm, +hhmm) or an abbreviation in zone_registry. offset is set in
+// seconds east of UTC; no designator at all means UTC.
+static bool
+parse_zone(const char* s, const char* c, const char* end, int& offset, parse_error& err)
 {
-  struct std::tm ts;
-  std::memset(&ts, 0, sizeof(ts));
-  
-  const char *c = s.c_str();
-  char buf[5];
+  int v;
+
+  offset = 0;
+  // found timezone
+  if (PEEK(c) =='+' || PEEK(c) == '-') {
+    int sign = (PEEK(c) == '+') ? 1 : -1;
+    ++c;
+    // get hour part of timezone bias
+    STEP_RANGE(c, '0', '2');
+    STEP_DIGIT(c);
+    SET_V(2);
+    if (v > 24)
+      HANDLE_ERROR_AT(parse_status::bad_zone, c - 2);
+    offset = sign * v * 3600;
+    if (PEEK(c) == ':')
+      ++c;
+    // get minutes part of timezone bias
+    STEP_RANGE(c, '0', '5');
+    STEP_DIGIT(c);
+    SET_V(2);
+    if (v > 59)
+      HANDLE_ERROR_AT(parse_status::bad_zone, c - 2);
+    offset += sign * v * 60;
+  } else if (c < end) {
+    if (!zone_registry::instance().find(c, end - c, offset))
+      HANDLE_ERROR(parse_status::unknown_zone);
+  }
+  return true;
+}
+
+// Every layout, a byte at a time; parse tries the canonical kernel
+// first, callers that already did go straight here.
+static bool
+parse_bytes(const char* s, std::size_t len, datetime& f, parse_error& err)
+{
+  f.hour = 0;
+  f.min = 0;
+  f.sec = 0;
+  f.nsec = 0;
+  f.utc_offset = 0;
+  err.status = parse_status::ok;
+  err.offset = 0;
+
+  const char *c = s;
+  const char *end = s + len;
   int v;
 
   // if found weekday, skip it.
-  if (IS_ALPHA(*c)) {
-    while (IS_ALPHA(*c)) {
+  if (IS_ALPHA(PEEK(c))) {
+    while (IS_ALPHA(PEEK(c))) {
       ++c;
     }
-    if (*c == ',')
+    if (PEEK(c) == ',')
       ++c;
-    if (*c != ' ')
-      HANDLE_EXCEPTION("format not supported: weekday sepratator");
+    if (PEEK(c) != ' ')
+      HANDLE_ERROR(parse_status::bad_weekday);
     ++c;
   }
 
   STEP_DIGIT(c);
   STEP_DIGIT(c);
-  if (*c == '\0')
-    HANDLE_EXCEPTION("format not supported: too short");
-  if (IS_DIGIT(*c)) {
-    ++c;
-    STEP_DIGIT(c);
-    SET_V(4);
-    if (v < 1900)
-      HANDLE_EXCEPTION("format not supported: wrong year");
-    ts.tm_year = v - 1900;
-    STEP_IF_DELIMITER(c);
-    STEP_DIGIT(c);
-    STEP_DIGIT(c);
-    SET_V(2);
-    if (v == 0 || v > 12)
-      HANDLE_EXCEPTION("format not supported: wrong month");
-    ts.tm_mon = v - 1;
-    STEP_IF_DELIMITER(c);
-    STEP_DIGIT(c);
-    STEP_DIGIT(c);
-    SET_V(2);
-    if (v == 0 || v > 31)
-      HANDLE_EXCEPTION("format not supported: wrong mday");
-    ts.tm_mday = v;
+  if (PEEK(c) == '\0')
+    HANDLE_ERROR(parse_status::too_short);
+  if (IS_DIGIT(PEEK(c))) {
+    // ISO8601 date, the common shapes decoded a word at a time
+    if (!parse_date8(c - 2, end, f, c)) {
+      ++c;
+      STEP_DIGIT(c);
+      SET_V(4);
+      if (v < 1900)
+        HANDLE_ERROR_AT(parse_status::bad_year, c - 4);
+      f.year = v;
+      STEP_IF_DELIMITER(c);
+      STEP_DIGIT(c);
+      STEP_DIGIT(c);
+      SET_V(2);
+      if (v == 0 || v > 12)
+        HANDLE_ERROR_AT(parse_status::bad_month, c - 2);
+      f.mon = v;
+      STEP_IF_DELIMITER(c);
+      STEP_DIGIT(c);
+      STEP_DIGIT(c);
+      SET_V(2);
+      if (v == 0 || v > 31)
+        HANDLE_ERROR_AT(parse_status::bad_mday, c - 2);
+      f.mday = v;
+    }
   } else {
     // common logfile format, HTTP format, RFC850 format 
     SET_V(2);
     if (v == 0 || v > 31)
-      HANDLE_EXCEPTION("format not supported: wrong mday");
-    ts.tm_mday = v;
+      HANDLE_ERROR_AT(parse_status::bad_mday, c - 2);
+    f.mday = v;
     STEP_DELIMITER(c);
-    if (*c == '\0') {
-      HANDLE_EXCEPTION("format not supported");
-    } else if (std::strncmp(c, "Jan", 3) == 0) {
-      ts.tm_mon = 0;
-    } else if (std::strncmp(c, "Feb", 3) == 0) {
-      ts.tm_mon = 1;
-    } else if (std::strncmp(c, "Mar", 3) == 0) {
-      ts.tm_mon = 2;
-    } else if (std::strncmp(c, "Apr", 3) == 0) {
-      ts.tm_mon = 3;
-    } else if (std::strncmp(c, "May", 3) == 0) {
-      ts.tm_mon = 4;
-    } else if (std::strncmp(c, "Jun", 3) == 0) {
-      ts.tm_mon = 5;
-    } else if (std::strncmp(c, "Jul", 3) == 0) {
-      ts.tm_mon = 6;
-    } else if (std::strncmp(c, "Aug", 3) == 0) {
-      ts.tm_mon = 7;
-    } else if (std::strncmp(c, "Sep", 3) == 0) {
-      ts.tm_mon = 8;
-    } else if (std::strncmp(c, "Oct", 3) == 0) {
-      ts.tm_mon = 9;
-    } else if (std::strncmp(c, "Nov", 3) == 0) {
-      ts.tm_mon = 10;
-    } else if (std::strncmp(c, "Dec", 3) == 0) {
-      ts.tm_mon = 11;
-    } else {
-      HANDLE_EXCEPTION("format not supported: wrong month");
-    }
+    if (end - c < 3)
+      HANDLE_ERROR(parse_status::too_short);
+    f.mon = month_from_name(c);
+    if (f.mon == 0)
+      HANDLE_ERROR(parse_status::bad_month);
     c += 3;
     STEP_DELIMITER(c);
     STEP_DIGIT(c);
     STEP_DIGIT(c);
-    if (IS_DIGIT(*c)) {
+    if (IS_DIGIT(PEEK(c))) {
       ++c;
       STEP_DIGIT(c);
       SET_V(4);
       if (v < 1900)
-        HANDLE_EXCEPTION("format not supported: wrong year");
-      ts.tm_year = v - 1900;
+        HANDLE_ERROR_AT(parse_status::bad_year, c - 4);
+      f.year = v;
     } else {
       SET_V(2);
-      ts.tm_year = v;
+      f.year = 1900 + v;
     }
   }
 
-  if (!check_date(ts.tm_year, ts.tm_mon+1, ts.tm_mday))
-    HANDLE_EXCEPTION("format not supported: invalid datetime");
+  if (!check_date(f.year, f.mon, f.mday))
+    HANDLE_ERROR(parse_status::invalid_date);
 
-  if (*c == ' ' || *c == 'T' || *c == ':')
+  if (PEEK(c) == ' ' || PEEK(c) == 'T' || PEEK(c) == ':')
     ++c;
 
-  if (*c == '\0')
-    return WRAP_RESULT(ts);
+  if (PEEK(c) == '\0')
+    return true;
 
-  STEP_RANGE(c, '0', '2');
-  STEP_DIGIT(c);
-  SET_V(2);
-  if (v > 24)
-    HANDLE_EXCEPTION("format not supported: hour is too big");
-  ts.tm_hour = v;
-  if (*c == ':')
-    ++c;
-  // found minute part
-  if (*c >= '0' && *c <= '5') {
-    ++c;
+  if (!parse_time8(c, end, f, c)) {
+    STEP_RANGE(c, '0', '2');
     STEP_DIGIT(c);
     SET_V(2);
-    if (v > 59)
-      HANDLE_EXCEPTION("format not supported");
-    ts.tm_min = v;
-    if (*c == ':')
+    if (v > 24)
+      HANDLE_ERROR_AT(parse_status::bad_hour, c - 2);
+    f.hour = v;
+    if (PEEK(c) == ':')
       ++c;
-  } else {
-    ts.tm_min = 0;
-  }
-  // found second part
-  if (*c >= '0' && *c <= '6') {
-    ++c;
-    STEP_DIGIT(c);
-    SET_V(2);
-    if (v > 61)
-      HANDLE_EXCEPTION("format not supported");
-    ts.tm_sec = v;
-  } else {
-    ts.tm_sec = 0;
+    // found minute part
+    if (PEEK(c) >= '0' && PEEK(c) <= '5') {
+      ++c;
+      STEP_DIGIT(c);
+      SET_V(2);
+      if (v > 59)
+        HANDLE_ERROR_AT(parse_status::bad_minute, c - 2);
+      f.min = v;
+      if (PEEK(c) == ':')
+        ++c;
+    }
+    // found second part
+    if (PEEK(c) >= '0' && PEEK(c) <= '6') {
+      ++c;
+      STEP_DIGIT(c);
+      SET_V(2);
+      if (v > 61)
+        HANDLE_ERROR_AT(parse_status::bad_second, c - 2);
+      f.sec = v;
+    }
   }
-  // found floating point part, skip it
-  if (*c == ',' || *c == '.') {
+  // found floating point part, digits past nanoseconds are dropped
+  if (PEEK(c) == ',' || PEEK(c) == '.') {
     ++c;
-    while (IS_DIGIT(*c))
+    const char* frac = c;
+    while (IS_DIGIT(PEEK(c)))
       ++c;
+    f.nsec = parse_fraction(frac, c - frac);
   }
-  while (*c == ' ')
+  while (PEEK(c) == ' ')
     ++c;
 
-  // found timezone
-  if (*c =='+' || *c == '-') {
-    bool positive = (*c == '+') ? false : true;
-    ++c;
-    // get hour part of timezone bias
-    STEP_RANGE(c, '0', '2');
-    STEP_DIGIT(c);
-    SET_V(2);
-    if (v > 24)
-      HANDLE_EXCEPTION("format not supported");
-    if (positive)
-        ts.tm_sec += v * 3600;
-    else
-        ts.tm_sec -= v * 3600;
-    if (*c == ':')
+  return parse_zone(s, c, end, f.utc_offset, err);
+}
+
+static bool
+parse(const char* s, std::size_t len, datetime& f, parse_error& err)
+{
+  if (parse_canonical(s, len, f)) {
+    err.status = parse_status::ok;
+    err.offset = 0;
+    return true;
+  }
+  return parse_bytes(s, len, f, err);
+}
+
+}  // end of namespace detail
+
+// Name of the kernel used for canonical ISO8601 strings on this CPU:
+// "scalar", "sse4.2" or "avx2".
+static const char*
+kernel_name()
+{
+#if defined(DATETIMELITE_X86_KERNELS)
+  if (detail::canonical_kernel_in_use() == detail::parse_canonical_avx2)
+    return "avx2";
+  if (detail::canonical_kernel_in_use() == detail::parse_canonical_sse42)
+    return "sse4.2";
+#endif
+  return "scalar";
+}
+
+// A point in time as seconds since the Unix epoch and nanoseconds
+// into that second.
+struct timestamp {
+  int64_t sec;
+  int32_t nsec;
+};
+
+// Seconds since the Unix epoch, the zone offset applied.
+static constexpr int64_t
+to_epoch(const datetime& dt)
+{
+  return days_from_civil(dt.year, dt.mon, dt.mday) * 86400
+    + dt.hour * 3600 + dt.min * 60 + dt.sec - dt.utc_offset;
+}
+
+// The wall clock fields of sec seconds since the epoch, as seen at
+// utc_offset seconds east of UTC. The inverse of to_epoch.
+static constexpr datetime
+from_epoch(int64_t sec, int32_t nsec = 0, int utc_offset = 0)
+{
+  const int64_t t = sec + utc_offset;
+  const int64_t days = (t >= 0 ? t : t - 86399) / 86400;
+  const int secs = static_cast<int>(t - days * 86400);
+  datetime dt = {};
+  civil_from_days(days, dt.year, dt.mon, dt.mday);
+  dt.hour = secs / 3600;
+  dt.min = secs / 60 % 60;
+  dt.sec = secs % 60;
+  dt.nsec = nsec;
+  dt.utc_offset = utc_offset;
+  return dt;
+}
+
+// The same instant with utc_offset 0 and every field back in its
+// range, e.g. hour 24 or a date moved by the zone carry into the day.
+static constexpr datetime
+to_utc(const datetime& dt)
+{
+  return from_epoch(to_epoch(dt), dt.nsec);
+}
+
+static bool
+try_parse(const char* s, std::size_t len, datetime& dt, parse_error& err)
+{
+  return detail::parse(s, len, dt, err);
+}
+
+static bool
+try_parse(const char* s, std::size_t len, struct std::tm& ts, parse_error& err)
+{
+  datetime f;
+  std::memset(&ts, 0, sizeof(ts));
+  if (!detail::parse(s, len, f, err))
+    return false;
+  ts.tm_year = f.year - 1900;
+  ts.tm_mon = f.mon - 1;
+  ts.tm_mday = f.mday;
+  ts.tm_hour = f.hour;
+  ts.tm_min = f.min;
+  ts.tm_sec = f.sec - f.utc_offset;
+  return true;
+}
+
+// Seconds since the Unix epoch, computed from the parsed fields
+// without going through struct std::tm and timegm.
+static bool
+try_parse_epoch(const char* s, std::size_t len, int64_t& sec, parse_error& err)
+{
+  datetime f;
+  if (!detail::parse(s, len, f, err))
+    return false;
+  sec = to_epoch(f);
+  return true;
+}
+
+static bool
+try_parse(const char* s, std::size_t len, timestamp& t, parse_error& err)
+{
+  datetime f;
+  if (!detail::parse(s, len, f, err))
+    return false;
+  t.sec = to_epoch(f);
+  t.nsec = f.nsec;
+  return true;
+}
+
+static bool
+try_parse(std::string_view s, datetime& dt, parse_error& err)
+{
+  return try_parse(s.data(), s.size(), dt, err);
+}
+
+static bool
+try_parse(std::string_view s, struct std::tm& ts, parse_error& err)
+{
+  return try_parse(s.data(), s.size(), ts, err);
+}
+
+static bool
+try_parse(std::string_view s, timestamp& t, parse_error& err)
+{
+  return try_parse(s.data(), s.size(), t, err);
+}
+
+static bool
+try_parse_epoch(std::string_view s, int64_t& sec, parse_error& err)
+{
+  return try_parse_epoch(s.data(), s.size(), sec, err);
+}
+
+static struct std::tm
+time_from_string(const char* s, std::size_t len)
+{
+  struct std::tm ts;
+  parse_error err;
+  if (!try_parse(s, len, ts, err))
+    HANDLE_EXCEPTION(err.what());
+  return ts;
+}
+
+static struct std::tm
+time_from_string(std::string_view s)
+{
+  return time_from_string(s.data(), s.size());
+}
+
+static struct std::tm
+time_from_string(const std::string& s)
+{
+  return time_from_string(s.data(), s.size());
+}
+
+static struct std::tm
+time_from_string(const char* s)
+{
+  return time_from_string(s, std::strlen(s));
+}
+
+static int64_t
+epoch_from_string(const char* s, std::size_t len)
+{
+  int64_t sec;
+  parse_error err;
+  if (!try_parse_epoch(s, len, sec, err))
+    HANDLE_EXCEPTION(err.what());
+  return sec;
+}
+
+static int64_t
+epoch_from_string(std::string_view s)
+{
+  return epoch_from_string(s.data(), s.size());
+}
+
+namespace detail {
+
+// Value of the two digits at p, or -1 if either is not a digit.
+static int
+two_digits(const char* p)
+{
+  unsigned a = static_cast<unsigned char>(p[0]) - '0';
+  unsigned b = static_cast<unsigned char>(p[1]) - '0';
+  return (a < 10 && b < 10) ? static_cast<int>(a * 10 + b) : -1;
+}
+
+// "HH:MM:SS" at c, the time layout shared by the fixed formats.
+static bool
+parse_hms(const char* s, const char* c, datetime& dt, parse_error& err)
+{
+  if (c[2] != ':' || c[5] != ':')
+    HANDLE_ERROR_AT(parse_status::expected_delimiter, c[2] != ':' ? c + 2 : c + 5);
+  uint64_t w = squeeze_time(c);
+  if (!all_digits8(w))
+    HANDLE_ERROR(parse_status::expected_digit);
+  uint64_t pairs = digit_pairs8(w);
+  dt.hour = lane(pairs, 0);
+  if (dt.hour > 24)
+    HANDLE_ERROR(parse_status::bad_hour);
+  dt.min = lane(pairs, 1);
+  if (dt.min > 59)
+    HANDLE_ERROR_AT(parse_status::bad_minute, c + 3);
+  dt.sec = lane(pairs, 2);
+  if (dt.sec > 61)
+    HANDLE_ERROR_AT(parse_status::bad_second, c + 6);
+  return true;
+}
+
+// Tables for the writers: "00" to "99" back to back, and the English
+// abbreviations three bytes apiece.
+static const char digit_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+static const char month_names[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+static const char weekday_names[] = "SunMonTueWedThuFriSat";
+
+static char*
+put2(char* p, unsigned v)
+{
+  std::memcpy(p, digit_pairs + v * 2, 2);
+  return p + 2;
+}
+
+static char*
+put4(char* p, unsigned v)
+{
+  return put2(put2(p, v / 100), v % 100);
+}
+
+static char*
+put_name(char* p, const char* table, unsigned i)
+{
+  std::memcpy(p, table + i * 3, 3);
+  return p + 3;
+}
+
+// "HH:MM:SS"
+static char*
+put_hms(char* p, const datetime& dt)
+{
+  p = put2(p, dt.hour);
+  *p++ = ':';
+  p = put2(p, dt.min);
+  *p++ = ':';
+  return put2(p, dt.sec);
+}
+
+// ".fff", ".ffffff" or ".fffffffff", the shortest that is exact, or
+// nothing for a whole second.
+static char*
+put_fraction(char* p, uint32_t nsec)
+{
+  if (nsec == 0)
+    return p;
+  *p++ = '.';
+  int digits = nsec % 1000000 == 0 ? 3 : nsec % 1000 == 0 ? 6 : 9;
+  char buf[9];
+  put4(put4(buf, nsec / 100000), nsec / 10 % 10000);
+  buf[8] = static_cast<char>('0' + nsec % 10);
+  std::memcpy(p, buf, digits);
+  return p + digits;
+}
+
+// "+hhmm", or "+hh:mm" with colon set.
+static char*
+put_offset(char* p, int offset, bool colon)
+{
+  *p++ = offset < 0 ? '-' : '+';
+  const unsigned minutes = static_cast<unsigned>(offset < 0 ? -offset : offset) / 60;
+  p = put2(p, minutes / 60 % 100);
+  if (colon)
+    *p++ = ':';
+  return put2(p, minutes % 60);
+}
+
+// 0 for Sunday, from days since the epoch (a Thursday).
+static unsigned
+weekday_from_days(int64_t z)
+{
+  return static_cast<unsigned>(z >= -4 ? (z + 4) % 7 : (z + 5) % 7 + 6);
+}
+
+}  // end of namespace detail
+
+// Parsers for a single known layout. Each one checks the length once
+// and then reads every field at a fixed position, without the layout
+// detection time_from_string does. Use them through parse<Format>().
+// Each also writes its layout, through format_to<Format>(): at most
+// max_size bytes, no NUL, and nothing at all (0) for a year outside
+// 0 to 9999.
+namespace format {
+
+// 1994-02-03T14:15:29[.fffffffff][Z|+hh:mm|+hhmm]
+struct iso8601 {
+  static bool
+  parse(const char* s, std::size_t len, datetime& dt, parse_error& err)
+  {
+    const char *c = s;
+    const char *end = s + len;
+    err.status = parse_status::ok;
+    err.offset = 0;
+    if (detail::parse_canonical(s, len, dt))
+      return true;
+    if (len < 19)
+      HANDLE_ERROR_AT(parse_status::too_short, end);
+    if (c[4] != '-' || c[7] != '-')
+      HANDLE_ERROR_AT(parse_status::expected_delimiter, c[4] != '-' ? c + 4 : c + 7);
+    uint64_t w = detail::squeeze_date(c);
+    if (!detail::all_digits8(w))
+      HANDLE_ERROR(parse_status::expected_digit);
+    uint64_t pairs = detail::digit_pairs8(w);
+    dt.year = detail::lane(pairs, 0) * 100 + detail::lane(pairs, 1);
+    if (dt.year < 1900)
+      HANDLE_ERROR(parse_status::bad_year);
+    dt.mon = detail::lane(pairs, 2);
+    if (dt.mon < 1 || dt.mon > 12)
+      HANDLE_ERROR_AT(parse_status::bad_month, c + 5);
+    dt.mday = detail::lane(pairs, 3);
+    if (dt.mday < 1 || dt.mday > 31)
+      HANDLE_ERROR_AT(parse_status::bad_mday, c + 8);
+    if (!check_date(dt.year, dt.mon, dt.mday))
+      HANDLE_ERROR_AT(parse_status::invalid_date, c + 10);
+    if (c[10] != 'T' && c[10] != ' ')
+      HANDLE_ERROR_AT(parse_status::expected_delimiter, c + 10);
+    if (!detail::parse_hms(s, c + 11, dt, err))
+      return false;
+    c += 19;
+    dt.nsec = 0;
+    if (PEEK(c) == '.' || PEEK(c) == ',') {
       ++c;
-    // get minutes part of timezone bias
-    STEP_RANGE(c, '0', '5');
-    STEP_DIGIT(c);
-    SET_V(2);
-    if (v > 59)
-      HANDLE_EXCEPTION("format not supported");
-    if (positive)
-      ts.tm_sec += v * 60;
+      const char* frac = c;
+      while (IS_DIGIT(PEEK(c)))
+        ++c;
+      dt.nsec = detail::parse_fraction(frac, c - frac);
+    }
+    return detail::parse_zone(s, c, end, dt.utc_offset, err);
+  }
+
+  static constexpr std::size_t max_size = 35;
+
+  // 1994-02-03T14:15:29.123Z, or +hh:mm in place of the Z
+  static std::size_t
+  write(char* buf, const datetime& dt)
+  {
+    if (dt.year < 0 || dt.year > 9999)
+      return 0;
+    char* p = detail::put4(buf, dt.year);
+    *p++ = '-';
+    p = detail::put2(p, dt.mon);
+    *p++ = '-';
+    p = detail::put2(p, dt.mday);
+    *p++ = 'T';
+    p = detail::put_fraction(detail::put_hms(p, dt), dt.nsec);
+    if (dt.utc_offset == 0)
+      *p++ = 'Z';
     else
-      ts.tm_sec -= v * 60;
-  } else if ((std::strcmp(c, "GMT") == 0)
-          || (std::strcmp(c, "UTC") == 0)
-          || (std::strcmp(c, "Z") == 0)) {
-    ts.tm_sec += 0;
-  } else if ((std::strcmp(c, "EST") == 0)
-          || (std::strcmp(c, "CDT") == 0)
-          || (std::strcmp(c, "E") == 0)) {
-    ts.tm_sec -= 5 * 3600;
-  } else if ((std::strcmp(c, "EDT") == 0)
-          || (std::strcmp(c, "D") == 0)) {
-    ts.tm_sec -= 4 * 3600;
-  } else if ((std::strcmp(c, "CST") == 0)
-          || (std::strcmp(c, "MDT") == 0)
-          || (std::strcmp(c, "F") == 0)) {
-    ts.tm_sec -= 6 * 3600;
-  } else if ((std::strcmp(c, "MST") == 0)
-          || (std::strcmp(c, "PDT") == 0)
-          || (std::strcmp(c,   "G") == 0)) {
-    ts.tm_sec -= 7 * 3600;
-  } else if ((std::strcmp(c, "PST") == 0)
-          || (std::strcmp(c, "H") == 0)) {
-    ts.tm_sec -= 8 * 3600;
-  } else if (std::strcmp(c, "A") == 0) {
-    ts.tm_sec -= 1 * 3600;
-  } else if (std::strcmp(c, "B") == 0) {
-    ts.tm_sec -= 2 * 3600;
-  } else if (std::strcmp(c, "C") == 0) {
-    ts.tm_sec -= 3 * 3600;
-  } else if (std::strcmp(c, "I") == 0) {
-    ts.tm_sec -= 9 * 3600;
-  } else if (std::strcmp(c, "K") == 0) {
-    ts.tm_sec -= 10 * 3600;
-  } else if (std::strcmp(c, "L") == 0) {
-    ts.tm_sec -= 11 * 3600;
-  } else if (std::strcmp(c, "M") == 0) {
-    ts.tm_sec -= 12 * 3600;
-  } else if (std::strcmp(c, "N") == 0) {
-    ts.tm_sec += 1 * 3600;
-  } else if (std::strcmp(c, "O") == 0) {
-    ts.tm_sec += 2 * 3600;
-  } else if (std::strcmp(c, "P") == 0) {
-    ts.tm_sec += 3 * 3600;
-  } else if (std::strcmp(c, "Q") == 0) {
-    ts.tm_sec += 4 * 3600;
-  } else if (std::strcmp(c, "R") == 0) {
-    ts.tm_sec += 5 * 3600;
-  } else if (std::strcmp(c, "S") == 0) {
-    ts.tm_sec += 6 * 3600;
-  } else if (std::strcmp(c, "T") == 0) {
-    ts.tm_sec += 7 * 3600;
-  } else if (std::strcmp(c, "U") == 0) {
-    ts.tm_sec += 8 * 3600;
-  } else if (std::strcmp(c, "V") == 0) {
-    ts.tm_sec += 9 * 3600;
-  } else if (std::strcmp(c, "W") == 0) {
-    ts.tm_sec += 10 * 3600;
-  } else if (std::strcmp(c, "X") == 0) {
-    ts.tm_sec += 11 * 3600;
-  } else if (std::strcmp(c, "Y") == 0) {
-    ts.tm_sec += 12 * 3600;
+      p = detail::put_offset(p, dt.utc_offset, true);
+    return p - buf;
+  }
+};
+
+// Wed, 09 Feb 1994 22:23:32 GMT
+struct rfc1123 {
+  static bool
+  parse(const char* s, std::size_t len, datetime& dt, parse_error& err)
+  {
+    const char *c = s;
+    const char *end = s + len;
+    err.status = parse_status::ok;
+    err.offset = 0;
+    if (len < 27)
+      HANDLE_ERROR_AT(parse_status::too_short, end);
+    if (!IS_ALPHA(c[0]) || !IS_ALPHA(c[1]) || !IS_ALPHA(c[2]) || c[3] != ',' || c[4] != ' ')
+      HANDLE_ERROR(parse_status::bad_weekday);
+    dt.mday = detail::two_digits(c + 5);
+    if (dt.mday < 1 || dt.mday > 31)
+      HANDLE_ERROR_AT(parse_status::bad_mday, c + 5);
+    if (c[7] != ' ' || c[11] != ' ' || c[16] != ' ' || c[25] != ' ')
+      HANDLE_ERROR_AT(parse_status::expected_delimiter, c + 7);
+    dt.mon = detail::month_from_name(c + 8);
+    if (dt.mon == 0)
+      HANDLE_ERROR_AT(parse_status::bad_month, c + 8);
+    int hi = detail::two_digits(c + 12);
+    int lo = detail::two_digits(c + 14);
+    if (hi < 0 || lo < 0 || hi * 100 + lo < 1900)
+      HANDLE_ERROR_AT(parse_status::bad_year, c + 12);
+    dt.year = hi * 100 + lo;
+    if (!check_date(dt.year, dt.mon, dt.mday))
+      HANDLE_ERROR_AT(parse_status::invalid_date, c + 16);
+    if (!detail::parse_hms(s, c + 17, dt, err))
+      return false;
+    dt.nsec = 0;
+    return detail::parse_zone(s, c + 26, end, dt.utc_offset, err);
   }
-  return WRAP_RESULT(ts);
+
+  static constexpr std::size_t max_size = 29;
+
+  // Wed, 09 Feb 1994 22:23:32 GMT, always in GMT as HTTP requires
+  static std::size_t
+  write(char* buf, const datetime& local)
+  {
+    const datetime dt = local.utc_offset ? to_utc(local) : local;
+    if (dt.year < 0 || dt.year > 9999)
+      return 0;
+    char* p = detail::put_name(buf, detail::weekday_names,
+                               detail::weekday_from_days(days_from_civil(dt.year, dt.mon, dt.mday)));
+    *p++ = ',';
+    *p++ = ' ';
+    p = detail::put2(p, dt.mday);
+    *p++ = ' ';
+    p = detail::put_name(p, detail::month_names, dt.mon - 1);
+    *p++ = ' ';
+    p = detail::put4(p, dt.year);
+    *p++ = ' ';
+    p = detail::put_hms(p, dt);
+    std::memcpy(p, " GMT", 4);
+    return p + 4 - buf;
+  }
+};
+
+// 03/Feb/1994:17:03:55 -0700
+struct clf {
+  static bool
+  parse(const char* s, std::size_t len, datetime& dt, parse_error& err)
+  {
+    const char *c = s;
+    const char *end = s + len;
+    err.status = parse_status::ok;
+    err.offset = 0;
+    if (len < 26)
+      HANDLE_ERROR_AT(parse_status::too_short, end);
+    dt.mday = detail::two_digits(c);
+    if (dt.mday < 1 || dt.mday > 31)
+      HANDLE_ERROR(parse_status::bad_mday);
+    if (c[2] != '/' || c[6] != '/' || c[11] != ':' || c[20] != ' ')
+      HANDLE_ERROR_AT(parse_status::expected_delimiter, c + 2);
+    dt.mon = detail::month_from_name(c + 3);
+    if (dt.mon == 0)
+      HANDLE_ERROR_AT(parse_status::bad_month, c + 3);
+    int hi = detail::two_digits(c + 7);
+    int lo = detail::two_digits(c + 9);
+    if (hi < 0 || lo < 0 || hi * 100 + lo < 1900)
+      HANDLE_ERROR_AT(parse_status::bad_year, c + 7);
+    dt.year = hi * 100 + lo;
+    if (!check_date(dt.year, dt.mon, dt.mday))
+      HANDLE_ERROR_AT(parse_status::invalid_date, c + 11);
+    if (!detail::parse_hms(s, c + 12, dt, err))
+      return false;
+    dt.nsec = 0;
+    return detail::parse_zone(s, c + 21, end, dt.utc_offset, err);
+  }
+
+  static constexpr std::size_t max_size = 26;
+
+  // 03/Feb/1994:17:03:55 -0700
+  static std::size_t
+  write(char* buf, const datetime& dt)
+  {
+    if (dt.year < 0 || dt.year > 9999)
+      return 0;
+    char* p = detail::put2(buf, dt.mday);
+    *p++ = '/';
+    p = detail::put_name(p, detail::month_names, dt.mon - 1);
+    *p++ = '/';
+    p = detail::put4(p, dt.year);
+    *p++ = ':';
+    p = detail::put_hms(p, dt);
+    *p++ = ' ';
+    return detail::put_offset(p, dt.utc_offset, false) - buf;
+  }
+};
+
+}  // end of namespace format
+
+template <typename Format>
+static bool
+parse(std::string_view s, datetime& dt, parse_error& err)
+{
+  return Format::parse(s.data(), s.size(), dt, err);
+}
+
+template <typename Format>
+static bool
+parse(std::string_view s, timestamp& t, parse_error& err)
+{
+  datetime dt;
+  if (!Format::parse(s.data(), s.size(), dt, err))
+    return false;
+  t.sec = to_epoch(dt);
+  t.nsec = dt.nsec;
+  return true;
+}
+
+template <typename Format>
+static std::size_t
+format_to(char* buf, const datetime& dt)
+{
+  return Format::write(buf, dt);
+}
+
+// t written as the wall clock at utc_offset seconds east of UTC.
+template <typename Format>
+static std::size_t
+format_to(char* buf, const timestamp& t, int utc_offset = 0)
+{
+  return Format::write(buf, from_epoch(t.sec, t.nsec, utc_offset));
 }
 
 }  // end of namespace
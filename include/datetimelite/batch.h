@@ -0,0 +1,190 @@
+/*
+The MIT License
+
+Copyright (c) 2011 lyo.kato@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _DATETIMELITE_BATCH_H_
+#define _DATETIMELITE_BATCH_H_
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "datetimelite.h"
+
+namespace datetimelite {
+
+// Caller-owned output of a batch parse, one entry per row. sec and
+// valid are required, nsec and offset may be null when not wanted.
+// offset is in minutes east of UTC. valid is a bitmap with row i at
+// bit i % 8 of byte i / 8, as in Arrow; an invalid row has its bit
+// cleared and zeros in the other columns.
+struct epoch_columns {
+  int64_t* sec;
+  int32_t* nsec;
+  int16_t* offset;
+  uint8_t* valid;
+};
+
+namespace detail {
+
+// A row source gives the loop below prefetch(i) and parse(i, dt).
+
+// Rows as an array of string_views. The bytes of a row are touched
+// some iterations ahead so they are in cache when it is parsed.
+struct string_view_rows {
+  static const std::size_t prefetch_distance = 16;
+
+  const std::string_view* in;
+  std::size_t n;
+
+  void prefetch(std::size_t i) const
+  {
+#if defined(__GNUC__)
+    if (i + prefetch_distance < n)
+      __builtin_prefetch(in[i + prefetch_distance].data());
+#else
+    (void)i;
+#endif
+  }
+
+  bool parse(std::size_t i, datetime& dt) const
+  {
+    parse_error err;
+    return detail::parse(in[i].data(), in[i].size(), dt, err);
+  }
+};
+
+// Arrow's string layout: row i is data[offsets[i], offsets[i + 1]).
+// A row whose bit is clear in the optional input bitmap is null and
+// is not looked at. The data is read in order, so no prefetch.
+struct offset_rows {
+  const char* data;
+  const int32_t* offsets;
+  const uint8_t* in_valid;
+
+  void prefetch(std::size_t) const {}
+
+  bool parse(std::size_t i, datetime& dt) const
+  {
+    if (in_valid && !(in_valid[i >> 3] & (1 << (i & 7))))
+      return false;
+    parse_error err;
+    const int32_t begin = offsets[i];
+    return detail::parse(data + begin, offsets[i + 1] - begin, dt, err);
+  }
+};
+
+// Rows of the same width packed back to back. When the width can be
+// the canonical layout, the kernel is picked once for the whole column
+// and only the trailing 'Z' is checked per row.
+struct fixed_rows {
+  const char* data;
+  std::size_t width;
+  const uint8_t* in_valid;
+  canonical_kernel kernel;
+
+  fixed_rows(const char* data, std::size_t width, const uint8_t* in_valid)
+    : data(data), width(width), in_valid(in_valid),
+      kernel(width >= canonical_min && width <= canonical_max && width != 21
+             ? canonical_kernel_in_use() : nullptr)
+  {
+  }
+
+  void prefetch(std::size_t) const {}
+
+  bool parse(std::size_t i, datetime& dt) const
+  {
+    if (in_valid && !(in_valid[i >> 3] & (1 << (i & 7))))
+      return false;
+    const char* s = data + i * width;
+    parse_error err;
+    if (!kernel)
+      return detail::parse(s, width, dt, err);
+    // the kernel has already said no, don't let parse ask it again
+    return (s[width - 1] == 'Z' && kernel(s, width, dt)) || detail::parse_bytes(s, width, dt, err);
+  }
+};
+
+// The loop every batch entry point shares. The row source is a template
+// argument so getting a row is inlined; there is no struct std::tm, no
+// exception and no branch on the outcome other than the parse itself.
+// Validity bits are gathered in a register and stored once per byte.
+template <typename Rows>
+static std::size_t
+parse_rows(const Rows& rows, std::size_t n, const epoch_columns& out)
+{
+  std::size_t count = 0;
+  uint8_t bits = 0;
+  for (std::size_t i = 0; i < n; ++i) {
+    rows.prefetch(i);
+    datetime dt;
+    const bool ok = rows.parse(i, dt);
+    out.sec[i] = ok ? to_epoch(dt) : 0;
+    if (out.nsec)
+      out.nsec[i] = ok ? dt.nsec : 0;
+    if (out.offset)
+      out.offset[i] = ok ? static_cast<int16_t>(dt.utc_offset / 60) : 0;
+    bits |= static_cast<uint8_t>(ok) << (i & 7);
+    count += ok;
+    if ((i & 7) == 7) {
+      out.valid[i >> 3] = bits;
+      bits = 0;
+    }
+  }
+  if (n & 7)
+    out.valid[n >> 3] = bits;
+  return count;
+}
+
+}  // end of namespace detail
+
+// Parses n strings into out and returns how many were valid.
+static std::size_t
+parse_batch(const std::string_view* in, std::size_t n, const epoch_columns& out)
+{
+  detail::string_view_rows rows = { in, n };
+  return detail::parse_rows(rows, n, out);
+}
+
+// Parses an Arrow-style string column of n rows: the values in one
+// buffer, row i from offsets[i] to offsets[i + 1] (n + 1 offsets).
+// in_valid is the column's own null bitmap, or null if it has none.
+static std::size_t
+parse_batch(const char* data, const int32_t* offsets, std::size_t n,
+            const epoch_columns& out, const uint8_t* in_valid = nullptr)
+{
+  detail::offset_rows rows = { data, offsets, in_valid };
+  return detail::parse_rows(rows, n, out);
+}
+
+// Parses n values of width bytes each stored back to back, a fixed
+// width column that needs no offsets.
+static std::size_t
+parse_batch_fixed(const char* data, std::size_t width, std::size_t n,
+                  const epoch_columns& out, const uint8_t* in_valid = nullptr)
+{
+  detail::fixed_rows rows(data, width, in_valid);
+  return detail::parse_rows(rows, n, out);
+}
+
+}  // end of namespace
+
+#endif
@@ -0,0 +1,191 @@
+/*
+The MIT License
+
+Copyright (c) 2011 lyo.kato@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _DATETIMELITE_CACHE_H_
+#define _DATETIMELITE_CACHE_H_
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include "datetimelite.h"
+
+namespace datetimelite {
+
+// Hits and misses of a parse_cache. Strings too long to be cached
+// count as misses.
+struct cache_stats {
+  uint64_t hits;
+  uint64_t misses;
+};
+
+// Results of try_parse kept by the raw bytes of the input, for inputs
+// that repeat: Last-Modified and If-Modified-Since values, cookie
+// expiries. Failures are kept as well. The table has a fixed number of
+// entries, in sets of four; a string that isn't in its set replaces
+// one of the four in turn. All memory is taken by the constructor.
+//
+// This is open addressing with the probe sequence cut at four slots.
+// A cache is full soon after warmup and must evict from then on. Plain
+// linear probing would then need tombstones or shifted runs, and the
+// probe chains would grow. A set keeps every lookup at four compares
+// and every eviction inside the set.
+//
+// A cache is not thread safe. local() gives each thread its own.
+class parse_cache {
+public:
+  static constexpr std::size_t max_key = 40;
+  static constexpr std::size_t default_entries = 4096;
+
+  // entries is rounded up to a power of two, and to at least one set.
+  explicit parse_cache(std::size_t entries = default_entries)
+  {
+    std::size_t sets = 1;
+    while (sets * ways < entries)
+      sets <<= 1;
+    set_mask_ = sets - 1;
+    table_.reset(new entry[sets * ways]());
+  }
+
+  parse_cache(const parse_cache&) = delete;
+  parse_cache& operator=(const parse_cache&) = delete;
+
+  // The cache of the calling thread, made on its first use. Each one
+  // holds default_entries entries of 96 bytes, 384 KB per thread that
+  // calls this. Threads that only parse now and then are better off
+  // with a smaller cache of their own.
+  static parse_cache&
+  local()
+  {
+    static thread_local parse_cache cache;
+    return cache;
+  }
+
+  bool
+  try_parse(const char* s, std::size_t len, datetime& dt, parse_error& err)
+  {
+    if (len == 0 || len > max_key) {
+      ++misses_;
+      return datetimelite::try_parse(s, len, dt, err);
+    }
+    const uint64_t h = hash(s, len);
+    entry* set = &table_[(h & set_mask_) * ways];
+    for (std::size_t i = 0; i < ways; ++i) {
+      const entry& e = set[i];
+      if (e.hash == h && e.len == len && std::memcmp(e.key, s, len) == 0) {
+        ++hits_;
+        dt = e.dt;
+        err.status = e.status;
+        err.offset = e.offset;
+        return e.status == parse_status::ok;
+      }
+    }
+    ++misses_;
+    entry& e = set[set[0].victim++ % ways];
+    const bool ok = datetimelite::try_parse(s, len, dt, err);
+    e.hash = h;
+    e.len = static_cast<uint8_t>(len);
+    std::memcpy(e.key, s, len);
+    e.dt = ok ? dt : datetime();
+    e.status = err.status;
+    e.offset = static_cast<uint32_t>(err.offset);
+    return ok;
+  }
+
+  bool
+  try_parse(std::string_view s, datetime& dt, parse_error& err)
+  {
+    return try_parse(s.data(), s.size(), dt, err);
+  }
+
+  bool
+  try_parse_epoch(std::string_view s, int64_t& sec, parse_error& err)
+  {
+    datetime dt;
+    if (!try_parse(s.data(), s.size(), dt, err))
+      return false;
+    sec = to_epoch(dt);
+    return true;
+  }
+
+  cache_stats
+  stats() const
+  {
+    return cache_stats{ hits_, misses_ };
+  }
+
+  // Forgets every entry and zeroes the counters, e.g. after the zone
+  // registry changed.
+  void
+  clear()
+  {
+    std::fill(table_.get(), table_.get() + (set_mask_ + 1) * ways, entry());
+    hits_ = misses_ = 0;
+  }
+
+private:
+  static constexpr std::size_t ways = 4;
+
+  struct entry {
+    uint64_t hash;
+    datetime dt;
+    uint32_t offset;
+    parse_status status;
+    uint8_t len;      // 0 for an empty entry
+    uint8_t victim;   // in the first entry of a set: the next to replace
+    char key[max_key];
+  };
+
+  // The input eight bytes at a time, each word mixed in with a multiply
+  // and folded so the low bits, which pick the set, depend on all of it.
+  static uint64_t
+  hash(const char* s, std::size_t len)
+  {
+    uint64_t h = len * 0x9E3779B97F4A7C15ULL;
+    std::size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+      uint64_t w;
+      std::memcpy(&w, s + i, 8);
+      h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+      h ^= h >> 31;
+    }
+    if (i < len) {
+      uint64_t w = 0;
+      std::memcpy(&w, s + i, len - i);
+      h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+      h ^= h >> 31;
+    }
+    return h ^ (h >> 29);
+  }
+
+  std::unique_ptr<entry[]> table_;
+  std::size_t set_mask_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+}  // end of namespace
+
+#endif
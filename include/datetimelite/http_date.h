@@ -0,0 +1,136 @@
+/*
+The MIT License
+
+Copyright (c) 2011 lyo.kato@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _DATETIMELITE_HTTP_DATE_H_
+#define _DATETIMELITE_HTTP_DATE_H_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include "datetimelite.h"
+
+namespace datetimelite {
+
+// The Date header (RFC 1123) and access log (CLF) strings of the current
+// second, formatted by the first caller in a new second and copied out
+// by everyone else. The strings sit behind a seqlock: readers take no
+// lock, and a reader that finds them being rewritten formats its own
+// copy instead of waiting. The words are loaded with acquire and stored
+// with release, so a reader that sees any new word also sees the
+// sequence number move and drops its copy; no fences are needed. One
+// object can be shared by every thread.
+class http_date {
+public:
+  static constexpr std::size_t rfc1123_size = format::rfc1123::max_size;
+  static constexpr std::size_t clf_size = format::clf::max_size;
+
+  // utc_offset, seconds east of UTC, is the zone the CLF string is in.
+  explicit http_date(int utc_offset = 0)
+    : utc_offset_(utc_offset)
+  {
+    for (std::atomic<uint64_t>& w : words_)
+      w.store(0, std::memory_order_relaxed);
+  }
+
+  http_date(const http_date&) = delete;
+  http_date& operator=(const http_date&) = delete;
+
+  // "Wed, 09 Feb 1994 22:23:32 GMT" into buf, rfc1123_size bytes.
+  std::size_t
+  rfc1123(char* buf)
+  {
+    return rfc1123(buf, std::time(nullptr));
+  }
+
+  std::size_t
+  rfc1123(char* buf, int64_t now)
+  {
+    return read(buf, now, 0, rfc1123_size);
+  }
+
+  // "09/Feb/1994:22:23:32 +0000" into buf, clf_size bytes.
+  std::size_t
+  clf(char* buf)
+  {
+    return clf(buf, std::time(nullptr));
+  }
+
+  std::size_t
+  clf(char* buf, int64_t now)
+  {
+    return read(buf, now, clf_word, clf_size);
+  }
+
+private:
+  static constexpr std::size_t word_bytes = sizeof(uint64_t);
+  static constexpr std::size_t clf_word = (rfc1123_size + word_bytes - 1) / word_bytes;
+  static constexpr std::size_t words = clf_word + (clf_size + word_bytes - 1) / word_bytes;
+
+  // Both strings of second now, the RFC 1123 one from word 0 and the
+  // CLF one from word clf_word.
+  void
+  write_strings(uint64_t* w, int64_t now) const
+  {
+    char* p = reinterpret_cast<char*>(w);
+    std::memset(p, 0, words * word_bytes);
+    const timestamp t = { now, 0 };
+    format_to<format::rfc1123>(p, t);
+    format_to<format::clf>(p + clf_word * word_bytes, t, utc_offset_);
+  }
+
+  std::size_t
+  read(char* buf, int64_t now, std::size_t first, std::size_t size)
+  {
+    uint64_t local[words];
+    uint64_t seq = seq_.load(std::memory_order_acquire);
+    if (!(seq & 1) && second_.load(std::memory_order_acquire) == now) {
+      for (std::size_t i = 0; i < words; ++i)
+        local[i] = words_[i].load(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == seq) {
+        std::memcpy(buf, reinterpret_cast<const char*>(local + first), size);
+        return size;
+      }
+    }
+    write_strings(local, now);
+    // take the writer's side if no one else has; otherwise just use ours
+    if (!(seq & 1) && seq_.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire)) {
+      for (std::size_t i = 0; i < words; ++i)
+        words_[i].store(local[i], std::memory_order_release);
+      second_.store(now, std::memory_order_release);
+      seq_.store(seq + 2, std::memory_order_release);
+    }
+    std::memcpy(buf, reinterpret_cast<const char*>(local + first), size);
+    return size;
+  }
+
+  const int utc_offset_;
+  std::atomic<uint64_t> seq_{0};
+  std::atomic<int64_t> second_{INT64_MIN};
+  std::atomic<uint64_t> words_[words];
+};
+
+}  // end of namespace
+
+#endif
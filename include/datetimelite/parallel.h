@@ -0,0 +1,331 @@
+/*
+The MIT License
+
+Copyright (c) 2011 lyo.kato@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _DATETIMELITE_PARALLEL_H_
+#define _DATETIMELITE_PARALLEL_H_
+#include <algorithm>
+#include <cstring>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "datetimelite/batch.h"
+#include "datetimelite/scan.h"
+
+namespace datetimelite {
+
+// A fixed set of threads running parallel_for jobs. Each thread owns a
+// range of chunk indices and takes from its front; a thread that runs
+// dry steals the back half of another's range. Ranges are a begin/end
+// pair packed in one atomic word, so taking and stealing are a CAS each
+// and no lock is held while chunks run. The calling thread works too,
+// so a pool of one thread starts no threads at all.
+class thread_pool {
+public:
+  explicit thread_pool(unsigned threads = std::thread::hardware_concurrency())
+    : queues_(new queue[std::max(threads, 1u)]), size_(std::max(threads, 1u))
+  {
+    for (unsigned i = 1; i < size_; ++i)
+      threads_.emplace_back(&thread_pool::worker_main, this, i);
+  }
+
+  ~thread_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : threads_)
+      t.join();
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  unsigned
+  size() const
+  {
+    return size_;
+  }
+
+  // Calls f(i) once for each i in [0, chunks) and returns when all
+  // calls have returned. f must not throw. One job runs at a time.
+  template <typename F>
+  void
+  parallel_for(std::size_t chunks, F&& f)
+  {
+    if (chunks == 0)
+      return;
+    if (size_ == 1 || chunks == 1) {
+      for (std::size_t i = 0; i < chunks; ++i)
+        f(i);
+      return;
+    }
+    std::lock_guard<std::mutex> job(job_mutex_);
+    for (unsigned i = 0; i < size_; ++i)
+      queues_[i].range.store(pack(chunks * i / size_, chunks * (i + 1) / size_),
+                             std::memory_order_relaxed);
+    // F is a reference type for a named callable, maybe a const one
+    typedef std::remove_reference_t<F> callable;
+    fn_ = const_cast<void*>(static_cast<const void*>(&f));
+    invoke_ = [](void* fn, std::size_t i) { (*static_cast<callable*>(fn))(i); };
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++generation_;
+      busy_ = size_ - 1;
+    }
+    wake_.notify_all();
+    work(0);
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return busy_ == 0; });
+  }
+
+private:
+  struct alignas(64) queue {
+    std::atomic<uint64_t> range{0};
+  };
+
+  static uint64_t
+  pack(uint64_t begin, uint64_t end)
+  {
+    return begin | (end << 32);
+  }
+
+  // Takes the first chunk of queue q.
+  bool
+  take(queue& q, std::size_t& chunk)
+  {
+    uint64_t r = q.range.load(std::memory_order_acquire);
+    for (;;) {
+      const uint32_t begin = static_cast<uint32_t>(r), end = static_cast<uint32_t>(r >> 32);
+      if (begin >= end)
+        return false;
+      if (q.range.compare_exchange_weak(r, pack(begin + 1, end), std::memory_order_acq_rel)) {
+        chunk = begin;
+        return true;
+      }
+    }
+  }
+
+  // Moves the back half of the victim's range into self's empty queue.
+  bool
+  steal(queue& victim, queue& self)
+  {
+    uint64_t r = victim.range.load(std::memory_order_acquire);
+    for (;;) {
+      const uint32_t begin = static_cast<uint32_t>(r), end = static_cast<uint32_t>(r >> 32);
+      if (begin >= end)
+        return false;
+      const uint32_t mid = begin + (end - begin) / 2;
+      if (victim.range.compare_exchange_weak(r, pack(begin, mid), std::memory_order_acq_rel)) {
+        self.range.store(pack(mid, end), std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  void
+  work(unsigned self)
+  {
+    std::size_t chunk;
+    for (;;) {
+      while (take(queues_[self], chunk))
+        invoke_(fn_, chunk);
+      bool stolen = false;
+      for (unsigned i = 1; i < size_ && !stolen; ++i)
+        stolen = steal(queues_[(self + i) % size_], queues_[self]);
+      if (!stolen)
+        return;
+    }
+  }
+
+  void
+  worker_main(unsigned self)
+  {
+    uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_)
+          return;
+        seen = generation_;
+      }
+      work(self);
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--busy_ == 0)
+        idle_.notify_one();
+    }
+  }
+
+  std::unique_ptr<queue[]> queues_;
+  unsigned size_;
+  std::vector<std::thread> threads_;
+  std::mutex job_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+  uint64_t generation_ = 0;
+  unsigned busy_ = 0;
+  bool stop_ = false;
+  void* fn_ = nullptr;
+  void (*invoke_)(void*, std::size_t) = nullptr;
+};
+
+// Rows per chunk: the input, about 32 bytes a row, and the 14 bytes a
+// row of output stay within a typical 256KB L2. Always a multiple of 8
+// so that no two chunks share a byte of the validity bitmap.
+static const std::size_t parallel_chunk_rows = 4096;
+
+namespace detail {
+
+// Runs make_rows(begin, count) through parse_rows for each chunk, with
+// out moved to the chunk's first row. Every chunk writes its own part
+// of the columns, so there is nothing to merge afterwards.
+template <typename MakeRows>
+static std::size_t
+parse_chunks(thread_pool& pool, std::size_t n, const epoch_columns& out,
+             std::size_t chunk_rows, MakeRows make_rows)
+{
+  chunk_rows = std::max<std::size_t>((chunk_rows + 7) & ~std::size_t(7), 8);
+  const std::size_t chunks = (n + chunk_rows - 1) / chunk_rows;
+  std::atomic<std::size_t> count(0);
+  pool.parallel_for(chunks, [&](std::size_t c) {
+    const std::size_t begin = c * chunk_rows;
+    const std::size_t rows = std::min(chunk_rows, n - begin);
+    const epoch_columns part = {
+      out.sec + begin,
+      out.nsec ? out.nsec + begin : nullptr,
+      out.offset ? out.offset + begin : nullptr,
+      out.valid + begin / 8,
+    };
+    count.fetch_add(parse_rows(make_rows(begin, rows), rows, part), std::memory_order_relaxed);
+  });
+  return count.load();
+}
+
+}  // end of namespace detail
+
+// parse_batch spread over the threads of pool. The results are the
+// same as the single threaded parse_batch, written in place.
+static std::size_t
+parse_batch(thread_pool& pool, const std::string_view* in, std::size_t n,
+            const epoch_columns& out, std::size_t chunk_rows = parallel_chunk_rows)
+{
+  return detail::parse_chunks(pool, n, out, chunk_rows, [in](std::size_t begin, std::size_t rows) {
+    return detail::string_view_rows { in + begin, rows };
+  });
+}
+
+static std::size_t
+parse_batch(thread_pool& pool, const char* data, const int32_t* offsets, std::size_t n,
+            const epoch_columns& out, const uint8_t* in_valid = nullptr,
+            std::size_t chunk_rows = parallel_chunk_rows)
+{
+  return detail::parse_chunks(pool, n, out, chunk_rows, [=](std::size_t begin, std::size_t) {
+    return detail::offset_rows { data, offsets + begin, in_valid ? in_valid + begin / 8 : nullptr };
+  });
+}
+
+// Bytes of a log per chunk in the parallel scan. Large enough that the
+// newline search at each end is noise, small enough to balance the
+// threads over a file of a few hundred MB.
+static const std::size_t parallel_chunk_bytes = 8 << 20;
+
+namespace detail {
+
+// Start of the first line at or after x: x itself if a line ends just
+// before it, otherwise the byte after the next newline.
+static std::size_t
+line_start(const char* data, std::size_t size, std::size_t x)
+{
+  if (x == 0 || x >= size)
+    return std::min(x, size);
+  if (data[x - 1] == '\n')
+    return x;
+  const void* nl = std::memchr(data + x, '\n', size - x);
+  return nl ? static_cast<const char*>(nl) - data + 1 : size;
+}
+
+}  // end of namespace detail
+
+// scan_lines over [data, data + size) spread over the threads of pool.
+// The buffer is cut every chunk_bytes and each cut moved to the start
+// of the next line, so every line is scanned by exactly one chunk.
+// The chunks' results are joined into out in file order, the same as
+// the single threaded scan would give.
+static scan_result
+scan_lines(thread_pool& pool, const char* data, std::size_t size, const scan_options& opt,
+           line_times& out, std::size_t chunk_bytes = parallel_chunk_bytes)
+{
+  chunk_bytes = std::max<std::size_t>(chunk_bytes, 1);
+  const std::size_t chunks = (size + chunk_bytes - 1) / chunk_bytes;
+  std::vector<line_times> parts(chunks);
+  std::vector<scan_result> results(chunks);
+  pool.parallel_for(chunks, [&](std::size_t c) {
+    const std::size_t begin = detail::line_start(data, size, c * chunk_bytes);
+    const std::size_t end = detail::line_start(data, size, std::min(size, (c + 1) * chunk_bytes));
+    line_times& part = parts[c];
+    results[c] = scan_lines(data + begin, end - begin, opt, [&part, begin](uint64_t offset, int64_t epoch) {
+      part.offset.push_back(begin + offset);
+      part.epoch.push_back(epoch);
+    });
+  });
+
+  scan_result r;
+  std::vector<std::size_t> at(chunks + 1, out.offset.size());
+  for (std::size_t c = 0; c < chunks; ++c) {
+    r.lines += results[c].lines;
+    r.parsed += results[c].parsed;
+    at[c + 1] = at[c] + parts[c].offset.size();
+  }
+  out.offset.resize(at[chunks]);
+  out.epoch.resize(at[chunks]);
+  pool.parallel_for(chunks, [&](std::size_t c) {
+    std::copy(parts[c].offset.begin(), parts[c].offset.end(), out.offset.begin() + at[c]);
+    std::copy(parts[c].epoch.begin(), parts[c].epoch.end(), out.epoch.begin() + at[c]);
+    parts[c] = line_times();
+  });
+  return r;
+}
+
+static scan_result
+scan_file(thread_pool& pool, const std::string& path, const scan_options& opt,
+          line_times& out, std::size_t chunk_bytes = parallel_chunk_bytes)
+{
+  mapped_file file(path);
+  return scan_lines(pool, file.data(), file.size(), opt, out, chunk_bytes);
+}
+
+}  // end of namespace
+
+#endif
@@ -0,0 +1,207 @@
+/*
+The MIT License
+
+Copyright (c) 2011 lyo.kato@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _DATETIMELITE_SCAN_H_
+#define _DATETIMELITE_SCAN_H_
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "datetimelite.h"
+
+namespace datetimelite {
+
+// A file mapped read-only for one sequential pass. Throws
+// std::system_error if it can't be opened or mapped.
+class mapped_file {
+public:
+  explicit mapped_file(const std::string& path)
+  {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      throw std::system_error(errno, std::generic_category(), path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      const int e = errno;
+      ::close(fd);
+      throw std::system_error(e, std::generic_category(), path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ > 0) {
+      void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        const int e = errno;
+        ::close(fd);
+        throw std::system_error(e, std::generic_category(), path);
+      }
+      ::madvise(p, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(p);
+    }
+    ::close(fd);
+  }
+
+  ~mapped_file()
+  {
+    if (data_)
+      ::munmap(const_cast<char*>(data_), size_);
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  const char*
+  data() const
+  {
+    return data_;
+  }
+
+  std::size_t
+  size() const
+  {
+    return size_;
+  }
+
+private:
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+// Where the timestamp is in each line. It starts column bytes into the
+// line, or, when prefix is given, just after the first prefix found from
+// there. It is width bytes long, or when width is 0 it runs up to the
+// first terminator byte, or to the end of the line if that is '\0' or
+// not found. Examples:
+//   "2011-01-23T00:24:31Z GET /"       terminator ' '
+//   "1.2.3.4 - - [23/Jan/2011:00:24:31 +0900] ..."
+//                                      prefix "[", terminator ']'
+//   "I 2011-01-23 00:24:31.250 ..."     column 2, width 23
+struct scan_options {
+  std::string_view prefix;
+  std::size_t column = 0;
+  std::size_t width = 0;
+  char terminator = '\0';
+};
+
+// Counts for one scan: lines seen and lines whose timestamp parsed.
+struct scan_result {
+  std::size_t lines = 0;
+  std::size_t parsed = 0;
+};
+
+namespace detail {
+
+// The timestamp field of the line [p, end), or false if the line is too
+// short or lacks the prefix.
+static bool
+timestamp_field(const char* p, const char* end, const scan_options& opt, std::string_view& field)
+{
+  if (static_cast<std::size_t>(end - p) < opt.column)
+    return false;
+  p += opt.column;
+  if (!opt.prefix.empty()) {
+    const std::string_view rest(p, end - p);
+    const std::size_t at = rest.find(opt.prefix);
+    if (at == std::string_view::npos)
+      return false;
+    p += at + opt.prefix.size();
+  }
+  if (opt.width) {
+    if (static_cast<std::size_t>(end - p) < opt.width)
+      return false;
+    field = std::string_view(p, opt.width);
+    return true;
+  }
+  const char* stop = opt.terminator ? static_cast<const char*>(std::memchr(p, opt.terminator, end - p)) : nullptr;
+  field = std::string_view(p, (stop ? stop : end) - p);
+  return true;
+}
+
+}  // end of namespace detail
+
+// Calls f(line_offset, epoch) for each line of [data, data + size) whose
+// timestamp parses, line_offset being where the line starts in data.
+// Lines end at '\n', a '\r' before it is dropped, and the last line
+// needs no newline. Nothing is copied or allocated.
+template <typename F>
+static scan_result
+scan_lines(const char* data, std::size_t size, const scan_options& opt, F&& f)
+{
+  scan_result r;
+  const char* p = data;
+  const char* const end = data + size;
+  while (p < end) {
+    const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    const char* next = nl ? nl + 1 : end;
+    const char* line_end = nl ? nl : end;
+    if (line_end > p && line_end[-1] == '\r')
+      --line_end;
+    ++r.lines;
+    std::string_view field;
+    datetime dt;
+    parse_error err;
+    if (detail::timestamp_field(p, line_end, opt, field)
+        && detail::parse(field.data(), field.size(), dt, err)) {
+      ++r.parsed;
+      f(static_cast<uint64_t>(p - data), to_epoch(dt));
+    }
+    p = next;
+  }
+  return r;
+}
+
+// scan_lines over a file, mapped with MADV_SEQUENTIAL for readahead.
+template <typename F>
+static scan_result
+scan_file(const std::string& path, const scan_options& opt, F&& f)
+{
+  mapped_file file(path);
+  return scan_lines(file.data(), file.size(), opt, f);
+}
+
+// Line offsets and epoch seconds of the lines that parsed, in order.
+struct line_times {
+  std::vector<uint64_t> offset;
+  std::vector<int64_t> epoch;
+};
+
+static scan_result
+scan_file(const std::string& path, const scan_options& opt, line_times& out)
+{
+  return scan_file(path, opt, [&out](uint64_t offset, int64_t epoch) {
+    out.offset.push_back(offset);
+    out.epoch.push_back(epoch);
+  });
+}
+
+}  // end of namespace
+
+#endif
@@ -0,0 +1,225 @@
+/*
+The MIT License
+
+Copyright (c) 2011 lyo.kato@gmail.com
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef _DATETIMELITE_STREAM_H_
+#define _DATETIMELITE_STREAM_H_
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "datetimelite.h"
+
+namespace datetimelite {
+
+namespace detail {
+
+// Index of the first byte where a and b differ, or len if none does,
+// comparing a word at a time.
+static std::size_t
+first_difference(const char* a, const char* b, std::size_t len)
+{
+  std::size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    const uint64_t x = load8(a + i) ^ load8(b + i);
+    if (x)
+      return i + (__builtin_ctzll(x) >> 3);
+  }
+  for (; i < len; ++i)
+    if (a[i] != b[i])
+      return i;
+  return len;
+}
+
+// Index of the last byte where a and b differ; there must be one.
+static std::size_t
+last_difference(const char* a, const char* b, std::size_t len)
+{
+  std::size_t i = len;
+  for (; i >= 8; i -= 8) {
+    const uint64_t x = load8(a + i - 8) ^ load8(b + i - 8);
+    if (x)
+      return i - 1 - (__builtin_clzll(x) >> 3);
+  }
+  while (i > 0 && a[i - 1] == b[i - 1])
+    --i;
+  return i - 1;
+}
+
+}  // end of namespace detail
+
+// Parses a stream of timestamps that mostly differ from the one before
+// only in the time, e.g. one per line of a log. It keeps the previous
+// input and result; when the next input has the same length and the
+// bytes that changed all fall in its "HH:MM:SS" and fraction, only
+// those fields are read again, and the date (already checked), month
+// name and zone are taken from the previous result. Anything else goes
+// through try_parse, so the results and errors are always the same as
+// try_parse's.
+class stream_parser {
+public:
+  static constexpr std::size_t max_size = 64;
+
+  bool
+  parse(const char* s, std::size_t len, datetime& dt, parse_error& err)
+  {
+    if (len == len_ && time_ != npos) {
+      const std::size_t first = detail::first_difference(prev_, s, len);
+      if (first == len) {
+        ++deltas_;
+        dt = dt_;
+        err.status = parse_status::ok;
+        err.offset = 0;
+        return true;
+      }
+      if (first >= time_ && delta(s, first, detail::last_difference(prev_, s, len))) {
+        dt = dt_;
+        err.status = parse_status::ok;
+        err.offset = 0;
+        return true;
+      }
+    }
+    return full(s, len, dt, err);
+  }
+
+  bool
+  parse(std::string_view s, datetime& dt, parse_error& err)
+  {
+    return parse(s.data(), s.size(), dt, err);
+  }
+
+  bool
+  parse_epoch(std::string_view s, int64_t& sec, parse_error& err)
+  {
+    datetime dt;
+    if (!parse(s.data(), s.size(), dt, err))
+      return false;
+    sec = to_epoch(dt);
+    return true;
+  }
+
+  // Forgets the previous input.
+  void
+  reset()
+  {
+    len_ = npos;
+  }
+
+  // Inputs that went through try_parse, and those that didn't.
+  uint64_t
+  full_parses() const
+  {
+    return fulls_;
+  }
+
+  uint64_t
+  delta_parses() const
+  {
+    return deltas_;
+  }
+
+private:
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  bool
+  full(const char* s, std::size_t len, datetime& dt, parse_error& err)
+  {
+    ++fulls_;
+    len_ = npos;
+    if (!datetimelite::try_parse(s, len, dt, err))
+      return false;
+    if (len > max_size)
+      return true;
+    std::memcpy(prev_, s, len);
+    len_ = len;
+    dt_ = dt;
+    find_layout();
+    return true;
+  }
+
+  // Where the time is: the last "HH:MM:SS" holding the parsed values,
+  // since a CLF year can look like an hour ("2017:17:17:17"), and the
+  // digits of a fraction right after it.
+  void
+  find_layout()
+  {
+    time_ = npos;
+    frac_begin_ = frac_end_ = 0;
+    for (std::size_t p = len_ >= 8 ? len_ - 7 : 0; p-- > 0;) {
+      if (prev_[p + 2] == ':' && prev_[p + 5] == ':' && detail::two_digits(prev_ + p) == dt_.hour
+          && detail::two_digits(prev_ + p + 3) == dt_.min && detail::two_digits(prev_ + p + 6) == dt_.sec) {
+        time_ = p;
+        break;
+      }
+    }
+    if (time_ == npos)
+      return;
+    std::size_t q = time_ + 8;
+    if (q < len_ && (prev_[q] == '.' || prev_[q] == ',')) {
+      frac_begin_ = frac_end_ = q + 1;
+      while (frac_end_ < len_ && IS_DIGIT(prev_[frac_end_]))
+        ++frac_end_;
+    }
+  }
+
+  // Bytes first to last of s differ from the previous input, and
+  // first is at or after the time. Reads the fields they touch.
+  bool
+  delta(const char* s, std::size_t first, std::size_t last)
+  {
+    const std::size_t time_end = time_ + 8;
+    if (last >= (frac_end_ > frac_begin_ ? frac_end_ : time_end))
+      return false;
+    datetime next = dt_;
+    if (first < time_end) {
+      parse_error ignored;
+      if (!detail::parse_hms(s, s + time_, next, ignored))
+        return false;
+    }
+    if (last >= time_end) {
+      if (s[time_end] != prev_[time_end])
+        return false;
+      for (std::size_t i = frac_begin_; i < frac_end_; ++i)
+        if (!IS_DIGIT(s[i]))
+          return false;
+      next.nsec = detail::parse_fraction(s + frac_begin_, frac_end_ - frac_begin_);
+    }
+    std::memcpy(prev_ + first, s + first, last - first + 1);
+    dt_ = next;
+    ++deltas_;
+    return true;
+  }
+
+  char prev_[max_size];
+  std::size_t len_ = npos;
+  datetime dt_;
+  std::size_t time_ = npos;
+  std::size_t frac_begin_ = 0;
+  std::size_t frac_end_ = 0;
+  uint64_t fulls_ = 0;
+  uint64_t deltas_ = 0;
+};
+
+}  // end of namespace
+
+#endif
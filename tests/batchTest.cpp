@@ -0,0 +1,151 @@
+#include "datetimelite/batch.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace datetimelite;
+
+static bool
+is_valid(const std::vector<uint8_t>& valid, size_t i)
+{
+  return valid[i / 8] & (1 << (i % 8));
+}
+
+TEST(batchTest, testParseBatch)
+{
+  std::vector<std::string_view> rows = {
+    "1994-02-03T14:15:29Z",
+    "1994-02-03T14:15:29.25+09:00",
+    "Wed, 09 Feb 1994 22:23:32 GMT",
+    "invalid format",
+    "",
+    "03/Feb/1994:17:03:55 -0700",
+    "1994-02-30",
+    "1970-01-01T00:00:00.000000001Z",
+    "1994-02-03 14:15:29 -0130",
+    "1994-02-03T14:15:29 QQQ",
+  };
+  const size_t n = rows.size();
+  std::vector<int64_t> sec(n, -1);
+  std::vector<int32_t> nsec(n, -1);
+  std::vector<int16_t> offset(n, -1);
+  std::vector<uint8_t> valid((n + 7) / 8, 0xff);
+  epoch_columns out = { sec.data(), nsec.data(), offset.data(), valid.data() };
+
+  EXPECT_EQ(6u, parse_batch(rows.data(), n, out));
+
+  for (size_t i = 0; i < n; ++i) {
+    int64_t expected;
+    parse_error err;
+    const bool ok = try_parse_epoch(rows[i], expected, err);
+    EXPECT_EQ(ok, is_valid(valid, i)) << rows[i];
+    EXPECT_EQ(ok ? expected : 0, sec[i]) << rows[i];
+    if (!ok) {
+      EXPECT_EQ(0, nsec[i]);
+      EXPECT_EQ(0, offset[i]);
+    }
+  }
+  EXPECT_EQ(760284929, sec[1] + 9 * 3600);
+  EXPECT_EQ(250000000, nsec[1]);
+  EXPECT_EQ(540, offset[1]);
+  EXPECT_EQ(-420, offset[5]);
+  EXPECT_EQ(1, nsec[7]);
+  EXPECT_EQ(-90, offset[8]);
+  EXPECT_EQ(0, valid[1] & ~0x03) << "bits past the last row are clear";
+}
+
+TEST(batchTest, testOptionalColumns)
+{
+  std::vector<std::string_view> rows(20, "1994-02-03T14:15:29Z");
+  rows[8] = "bad";
+  std::vector<int64_t> sec(rows.size());
+  std::vector<uint8_t> valid(3);
+  epoch_columns out = { sec.data(), nullptr, nullptr, valid.data() };
+
+  EXPECT_EQ(19u, parse_batch(rows.data(), rows.size(), out));
+  EXPECT_EQ(0xff, valid[0]);
+  EXPECT_EQ(0xfe, valid[1]);
+  EXPECT_EQ(0x0f, valid[2]);
+  EXPECT_EQ(760284929, sec[19]);
+  EXPECT_EQ(0, sec[8]);
+}
+
+TEST(batchTest, testEmpty)
+{
+  uint8_t valid = 0xff;
+  epoch_columns out = { nullptr, nullptr, nullptr, &valid };
+  EXPECT_EQ(0u, parse_batch(nullptr, 0, out));
+  EXPECT_EQ(0xff, valid);
+}
+
+TEST(batchTest, testOffsets)
+{
+  const std::string data =
+    "1994-02-03T14:15:29Z"
+    "03/Feb/1994:17:03:55 -0700"
+    "bogus"
+    "Wed, 09 Feb 1994 22:23:32 GMT"
+    "1994-02-03T14:15:29.5Z";
+  std::vector<int32_t> offsets = { 0, 20, 46, 51, 51, 80, 102 };
+  const size_t n = offsets.size() - 1;
+  std::vector<int64_t> sec(n);
+  std::vector<int32_t> nsec(n);
+  std::vector<uint8_t> valid(1);
+  epoch_columns out = { sec.data(), nsec.data(), nullptr, valid.data() };
+
+  EXPECT_EQ(4u, parse_batch(data.data(), offsets.data(), n, out));
+  EXPECT_EQ(0x33, valid[0]);
+  EXPECT_EQ(760284929, sec[0]);
+  EXPECT_EQ(760320235, sec[1]);
+  EXPECT_EQ(760832612, sec[4]);
+  EXPECT_EQ(760284929, sec[5]);
+  EXPECT_EQ(500000000, nsec[5]);
+
+  // rows that are null in the input stay null
+  const uint8_t in_valid = 0x3e;
+  EXPECT_EQ(3u, parse_batch(data.data(), offsets.data(), n, out, &in_valid));
+  EXPECT_EQ(0x32, valid[0]);
+  EXPECT_EQ(0, sec[0]);
+}
+
+TEST(batchTest, testFixedWidth)
+{
+  std::vector<std::string> values = {
+    "1994-02-03T14:15:29Z",
+    "1994-02-03 14:15:29Z",
+    "1994-02-30T14:15:29Z",
+    "1970-01-01T00:00:00Z",
+    "1994-02-03T14:15:29A",
+    "19940203T141529+0900",
+  };
+  std::string data;
+  std::vector<std::string_view> views;
+  for (const std::string& v : values)
+    data += v;
+  for (size_t i = 0; i < values.size(); ++i)
+    views.push_back(std::string_view(data).substr(i * 20, 20));
+  const size_t n = values.size();
+
+  std::vector<int64_t> sec(n), expected_sec(n);
+  std::vector<int16_t> offset(n), expected_offset(n);
+  std::vector<uint8_t> valid(1), expected_valid(1);
+  epoch_columns out = { sec.data(), nullptr, offset.data(), valid.data() };
+  epoch_columns expected = { expected_sec.data(), nullptr, expected_offset.data(), expected_valid.data() };
+
+  // same answers as the generic path, row by row
+  EXPECT_EQ(parse_batch(views.data(), n, expected), parse_batch_fixed(data.data(), 20, n, out));
+  EXPECT_EQ(expected_valid, valid);
+  EXPECT_EQ(expected_sec, sec);
+  EXPECT_EQ(expected_offset, offset);
+  EXPECT_EQ(0, valid[0] & 0x04);
+  EXPECT_EQ(0, sec[3]);
+  EXPECT_NE(0, valid[0] & 0x08);
+
+  const uint8_t in_valid = 0x01;
+  EXPECT_EQ(1u, parse_batch_fixed(data.data(), 20, n, out, &in_valid));
+  EXPECT_EQ(0x01, valid[0]);
+
+  EXPECT_EQ(0u, parse_batch_fixed(data.data(), 0, 3, out));
+  EXPECT_EQ(0, valid[0]);
+}
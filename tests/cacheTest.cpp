@@ -0,0 +1,90 @@
+#include "datetimelite/cache.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace datetimelite;
+
+TEST(cacheTest, testHitMiss)
+{
+  parse_cache cache(64);
+  datetime dt;
+  parse_error err;
+  int64_t sec;
+
+  EXPECT_TRUE(cache.try_parse_epoch("Wed, 09 Feb 1994 22:23:32 GMT", sec, err));
+  EXPECT_EQ(760832612, sec);
+  EXPECT_TRUE(cache.try_parse_epoch("Wed, 09 Feb 1994 22:23:32 GMT", sec, err));
+  EXPECT_EQ(760832612, sec);
+  EXPECT_EQ(1u, cache.stats().hits);
+  EXPECT_EQ(1u, cache.stats().misses);
+
+  // failures are kept with their reason and offset
+  EXPECT_FALSE(cache.try_parse("1994-13-03", dt, err));
+  EXPECT_FALSE(cache.try_parse("1994-13-03", dt, err));
+  EXPECT_EQ(parse_status::bad_month, err.status);
+  EXPECT_EQ(5u, err.offset);
+  EXPECT_EQ(2u, cache.stats().hits);
+
+  // a string that only shares a prefix is a different key
+  EXPECT_TRUE(cache.try_parse("1994-02-03T14:15:29.5+09:00", dt, err));
+  EXPECT_TRUE(cache.try_parse("1994-02-03T14:15:29.5+09:30", dt, err));
+  EXPECT_EQ(34200, dt.utc_offset);
+  EXPECT_EQ(500000000, dt.nsec);
+  EXPECT_EQ(4u, cache.stats().misses);
+
+  // too long to keep, and empty
+  const std::string padded = "1994-02-03T14:15:29.123456789+09:00" + std::string(10, ' ');
+  EXPECT_TRUE(cache.try_parse(padded, dt, err));
+  EXPECT_TRUE(cache.try_parse(padded, dt, err));
+  EXPECT_EQ(123456789, dt.nsec);
+  EXPECT_FALSE(cache.try_parse("", dt, err));
+  EXPECT_EQ(7u, cache.stats().misses);
+
+  cache.clear();
+  EXPECT_EQ(0u, cache.stats().hits + cache.stats().misses);
+  EXPECT_TRUE(cache.try_parse_epoch("Wed, 09 Feb 1994 22:23:32 GMT", sec, err));
+  EXPECT_EQ(1u, cache.stats().misses);
+}
+
+TEST(cacheTest, testBounded)
+{
+  // many more distinct strings than entries: every answer stays right
+  parse_cache cache(16);
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 1000; ++i) {
+      char buf[64];
+      std::snprintf(buf, sizeof(buf), "Wed, 09 Feb 1994 %02d:%02d:%02d GMT", i / 3600, i / 60 % 60, i % 60);
+      int64_t sec = 0;
+      parse_error err;
+      ASSERT_TRUE(cache.try_parse_epoch(buf, sec, err)) << buf;
+      ASSERT_EQ(760752000 + i, sec) << buf;
+      // the second look at the same string always hits
+      const uint64_t hits = cache.stats().hits;
+      ASSERT_TRUE(cache.try_parse_epoch(buf, sec, err));
+      ASSERT_EQ(hits + 1, cache.stats().hits);
+    }
+  }
+  EXPECT_EQ(3000u, cache.stats().hits);
+  EXPECT_EQ(3000u, cache.stats().misses);
+}
+
+TEST(cacheTest, testLocal)
+{
+  datetime dt;
+  parse_error err;
+  parse_cache::local().try_parse("1994-02-03T14:15:29Z", dt, err);
+  parse_cache::local().try_parse("1994-02-03T14:15:29Z", dt, err);
+  EXPECT_EQ(1u, parse_cache::local().stats().hits);
+
+  cache_stats other = { 99, 99 };
+  std::thread([&other] {
+    datetime dt;
+    parse_error err;
+    parse_cache::local().try_parse("1994-02-03T14:15:29Z", dt, err);
+    other = parse_cache::local().stats();
+  }).join();
+  EXPECT_EQ(0u, other.hits);
+  EXPECT_EQ(1u, other.misses);
+}
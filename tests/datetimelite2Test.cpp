@@ -10,9 +10,33 @@ TEST(datetimeliteTest, testPtime)
   boost::optional<boost::posix_time::ptime> t1 = datetimelite2::time_from_string("Wed, 09 Feb 1994 22:23:32 GMT");
   EXPECT_EQ("1994-Feb-09 22:23:32", boost::posix_time::to_simple_string(*t1));
   boost::optional<boost::posix_time::ptime> t2 = datetimelite2::time_from_string("1994-02-03T14:15:29 +09:00");
-  EXPECT_EQ("1994-Feb-02 00:45:29", boost::posix_time::to_simple_string(*t2));
+  EXPECT_EQ("1994-Feb-03 05:15:29", boost::posix_time::to_simple_string(*t2));
 
   boost::optional<boost::posix_time::ptime> t3 = datetimelite2::time_from_string("invalid format");
   EXPECT_FALSE(t3);
 }
 
+
+TEST(datetimeliteTest, testBoundedInput)
+{
+  const char buf[] = "[1994-02-03T14:15:29Z][09 Feb 1994 22:23:32 GMT]";
+  std::string_view line(buf, sizeof(buf) - 1);
+
+  boost::optional<boost::posix_time::ptime> t1 = datetimelite2::time_from_string(line.substr(1, 20));
+  EXPECT_EQ("1994-Feb-03 14:15:29", boost::posix_time::to_simple_string(*t1));
+  boost::optional<boost::posix_time::ptime> t2 = datetimelite2::time_from_string(buf + 23, 24);
+  EXPECT_EQ("1994-Feb-09 22:23:32", boost::posix_time::to_simple_string(*t2));
+  boost::optional<boost::posix_time::ptime> t3 = datetimelite2::time_from_string(buf + 1, 3);
+  EXPECT_FALSE(t3);
+}
+
+TEST(datetimeliteTest, testFraction)
+{
+  boost::optional<boost::posix_time::ptime> t1 = datetimelite2::time_from_string("1994-02-03 14:15:29.123456");
+  EXPECT_EQ("1994-Feb-03 14:15:29.123456", boost::posix_time::to_simple_string(*t1));
+  boost::optional<boost::posix_time::ptime> t2 = datetimelite2::time_from_string("1994-02-03 14:15:29.999");
+  EXPECT_EQ("1994-Feb-03 14:15:29.999000", boost::posix_time::to_simple_string(*t2));
+  EXPECT_TRUE(*t1 < *t2);
+  boost::optional<boost::posix_time::ptime> t3 = datetimelite2::time_from_string("03/Feb/1994:17:03:55.5 -0700");
+  EXPECT_EQ("1994-Feb-04 00:03:55.500000", boost::posix_time::to_simple_string(*t3));
+}
@@ -59,3 +59,459 @@ TEST(datetimeliteTest, testPtime)
   EXPECT_EQ("1994-Feb-02 00:45:29", boost::posix_time::to_simple_string(t2));
 }
 
+TEST(datetimeliteTest, testBoundedInput)
+{
+  const char buf[] = "[1994-02-03T14:15:29Z][09 Feb 1994 22:23:32 GMT]";
+  std::string_view line(buf, sizeof(buf) - 1);
+
+  struct std::tm ts = datetimelite::time_from_string(line.substr(1, 20));
+  EXPECT_EQ(94, ts.tm_year);
+  EXPECT_EQ(3, ts.tm_mday);
+  EXPECT_EQ(29, ts.tm_sec);
+
+  ts = datetimelite::time_from_string(buf + 23, 24);
+  EXPECT_EQ(9, ts.tm_mday);
+  EXPECT_EQ(22, ts.tm_hour);
+  EXPECT_EQ(32, ts.tm_sec);
+
+  // the bound is the end of input, even without a NUL there
+  ts = datetimelite::time_from_string(buf + 1, 10);
+  EXPECT_EQ(3, ts.tm_mday);
+  EXPECT_EQ(0, ts.tm_hour);
+  EXPECT_THROW(datetimelite::time_from_string(buf + 1, 3), std::invalid_argument);
+  EXPECT_THROW(datetimelite::time_from_string(buf + 23, 5), std::invalid_argument);
+}
+
+TEST(datetimeliteTest, testTryParse)
+{
+  struct std::tm ts;
+  datetimelite::parse_error err;
+
+  EXPECT_TRUE(datetimelite::try_parse("Wed, 09 Feb 1994 22:23:32 GMT", ts, err));
+  EXPECT_EQ(datetimelite::parse_status::ok, err.status);
+  EXPECT_EQ(9, ts.tm_mday);
+  EXPECT_EQ(32, ts.tm_sec);
+
+  EXPECT_FALSE(datetimelite::try_parse("invalid format", ts, err));
+  EXPECT_EQ(datetimelite::parse_status::expected_digit, err.status);
+  EXPECT_EQ(8u, err.offset);
+
+  EXPECT_FALSE(datetimelite::try_parse("Wed;09 Feb 1994", ts, err));
+  EXPECT_EQ(datetimelite::parse_status::bad_weekday, err.status);
+  EXPECT_EQ(3u, err.offset);
+
+  EXPECT_FALSE(datetimelite::try_parse("1994-13-03 14:15:29", ts, err));
+  EXPECT_EQ(datetimelite::parse_status::bad_month, err.status);
+  EXPECT_EQ(5u, err.offset);
+
+  EXPECT_FALSE(datetimelite::try_parse("09 Fev 1994", ts, err));
+  EXPECT_EQ(datetimelite::parse_status::bad_month, err.status);
+  EXPECT_EQ(3u, err.offset);
+
+  EXPECT_FALSE(datetimelite::try_parse("1994-02-30", ts, err));
+  EXPECT_EQ(datetimelite::parse_status::invalid_date, err.status);
+
+  EXPECT_FALSE(datetimelite::try_parse("1994-02-03 14:15:29 +2500", ts, err));
+  EXPECT_EQ(datetimelite::parse_status::bad_zone, err.status);
+  EXPECT_EQ(21u, err.offset);
+  EXPECT_STREQ("format not supported: wrong timezone", err.what());
+
+  try {
+    datetimelite::time_from_string("1994-02-03 14:15:29 +2500");
+    FAIL();
+  } catch (const std::invalid_argument& e) {
+    EXPECT_STREQ("format not supported: wrong timezone", e.what());
+  }
+}
+
+TEST(datetimeliteTest, testEpoch)
+{
+  EXPECT_EQ(760832612, datetimelite::epoch_from_string("Wed, 09 Feb 1994 22:23:32 GMT"));
+  EXPECT_EQ(760252529, datetimelite::epoch_from_string("1994-02-03 14:15:29+09:00"));
+  EXPECT_EQ(760284929, datetimelite::epoch_from_string("19940203T141529Z"));
+  EXPECT_EQ(760233600, datetimelite::epoch_from_string("1994-02-03"));
+  EXPECT_EQ(951782400, datetimelite::epoch_from_string("2000-02-29"));
+  EXPECT_EQ(0, datetimelite::epoch_from_string("1970-01-01T00:00:00Z"));
+
+  const char* inputs[] = {
+    "Tuesday, 08-Feb-94 14:15:29 GMT",
+    "03/Feb/1994:17:03:55 -0700",
+    "1994-02-03 14:15:29 -0100",
+    "1994-02-03 14:15:29.5+0900",
+    "08-Feb-1994",
+    "2038-01-19T03:14:08Z",
+    "1999-12-31 23:59:60",
+  };
+  for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i) {
+    struct std::tm ts = datetimelite::time_from_string(inputs[i]);
+    EXPECT_EQ(static_cast<int64_t>(timegm(&ts)), datetimelite::epoch_from_string(inputs[i])) << inputs[i];
+  }
+
+  int64_t sec;
+  datetimelite::parse_error err;
+  EXPECT_FALSE(datetimelite::try_parse_epoch("1994-02-30", sec, err));
+  EXPECT_EQ(datetimelite::parse_status::invalid_date, err.status);
+  EXPECT_THROW(datetimelite::epoch_from_string("invalid format"), std::invalid_argument);
+}
+
+TEST(datetimeliteTest, testFraction)
+{
+  datetimelite::timestamp t;
+  datetimelite::parse_error err;
+
+  EXPECT_TRUE(datetimelite::try_parse("1994-02-03 14:15:29.123456", t, err));
+  EXPECT_EQ(760284929, t.sec);
+  EXPECT_EQ(123456000, t.nsec);
+  EXPECT_TRUE(datetimelite::try_parse("1994-02-03 14:15:29.999", t, err));
+  EXPECT_EQ(760284929, t.sec);
+  EXPECT_EQ(999000000, t.nsec);
+  EXPECT_TRUE(datetimelite::try_parse("1994-02-03 14:15:29,5+0900", t, err));
+  EXPECT_EQ(760252529, t.sec);
+  EXPECT_EQ(500000000, t.nsec);
+  EXPECT_TRUE(datetimelite::try_parse("1994-02-03T14:15:29.123456789123Z", t, err));
+  EXPECT_EQ(123456789, t.nsec);
+  EXPECT_TRUE(datetimelite::try_parse("1994-02-03T14:15:29Z", t, err));
+  EXPECT_EQ(0, t.nsec);
+  EXPECT_TRUE(datetimelite::try_parse("1994-02-03T14:15:29.Z", t, err));
+  EXPECT_EQ(0, t.nsec);
+}
+
+std::string getutcstring(const std::string& s)
+{
+  datetimelite::datetime dt;
+  datetimelite::parse_error err;
+  if (!datetimelite::try_parse(s, dt, err))
+    return err.what();
+  datetimelite::datetime utc = datetimelite::to_utc(dt);
+  std::ostringstream os;
+  os << "Offset:" << dt.utc_offset << "|";
+  os << "Year:" << utc.year << "|";
+  os << "Month:" << utc.mon << "|";
+  os << "Day:" << utc.mday << "|";
+  os << "Hour:" << utc.hour << "|";
+  os << "Min:" << utc.min << "|";
+  os << "Sec:" << utc.sec;
+  return os.str();
+}
+
+TEST(datetimeliteTest, testUtc)
+{
+  datetimelite::datetime dt;
+  datetimelite::parse_error err;
+  EXPECT_TRUE(datetimelite::try_parse("1994-02-03 14:15:29.5+09:00", dt, err));
+  EXPECT_EQ(1994, dt.year);
+  EXPECT_EQ(2, dt.mon);
+  EXPECT_EQ(3, dt.mday);
+  EXPECT_EQ(14, dt.hour);
+  EXPECT_EQ(15, dt.min);
+  EXPECT_EQ(29, dt.sec);
+  EXPECT_EQ(500000000, dt.nsec);
+  EXPECT_EQ(32400, dt.utc_offset);
+
+  EXPECT_EQ("Offset:32400|Year:1994|Month:2|Day:3|Hour:5|Min:15|Sec:29", getutcstring("1994-02-03 14:15:29+09:00"));
+  EXPECT_EQ("Offset:32400|Year:1994|Month:2|Day:2|Hour:16|Min:0|Sec:0", getutcstring("1994-02-03 01:00:00+0900"));
+  EXPECT_EQ("Offset:-25200|Year:1994|Month:2|Day:4|Hour:0|Min:3|Sec:55", getutcstring("03/Feb/1994:17:03:55 -0700"));
+  EXPECT_EQ("Offset:3600|Year:1999|Month:12|Day:31|Hour:23|Min:30|Sec:0", getutcstring("2000-01-01 00:30:00+0100"));
+  EXPECT_EQ("Offset:0|Year:2000|Month:3|Day:1|Hour:0|Min:0|Sec:0", getutcstring("2000-02-29 24:00:00Z"));
+  EXPECT_EQ("Offset:0|Year:1994|Month:2|Day:9|Hour:22|Min:23|Sec:32", getutcstring("Wed, 09 Feb 1994 22:23:32 GMT"));
+}
+
+template <typename Format>
+void expectSameAsGeneric(const char* s)
+{
+  datetimelite::datetime expected, actual;
+  datetimelite::parse_error err;
+  ASSERT_TRUE(datetimelite::try_parse(s, expected, err)) << s;
+  ASSERT_TRUE(datetimelite::parse<Format>(s, actual, err)) << s << ": " << err.what();
+  EXPECT_EQ(expected.year, actual.year) << s;
+  EXPECT_EQ(expected.mon, actual.mon) << s;
+  EXPECT_EQ(expected.mday, actual.mday) << s;
+  EXPECT_EQ(expected.hour, actual.hour) << s;
+  EXPECT_EQ(expected.min, actual.min) << s;
+  EXPECT_EQ(expected.sec, actual.sec) << s;
+  EXPECT_EQ(expected.nsec, actual.nsec) << s;
+  EXPECT_EQ(expected.utc_offset, actual.utc_offset) << s;
+}
+
+TEST(datetimeliteTest, testFormat)
+{
+  using namespace datetimelite;
+  expectSameAsGeneric<format::iso8601>("1994-02-03T14:15:29");
+  expectSameAsGeneric<format::iso8601>("1994-02-03 14:15:29");
+  expectSameAsGeneric<format::iso8601>("1994-02-03T14:15:29Z");
+  expectSameAsGeneric<format::iso8601>("1994-02-03T14:15:29.123456789Z");
+  expectSameAsGeneric<format::iso8601>("1994-02-03T14:15:29,5+09:00");
+  expectSameAsGeneric<format::iso8601>("2000-02-29T24:00:00-0130");
+  expectSameAsGeneric<format::rfc1123>("Wed, 09 Feb 1994 22:23:32 GMT");
+  expectSameAsGeneric<format::rfc1123>("Wed, 09 Feb 1994 22:23:32 +0100");
+  expectSameAsGeneric<format::clf>("03/Feb/1994:17:03:55 -0700");
+  expectSameAsGeneric<format::clf>("31/Dec/2010:23:59:60 +0000");
+
+  datetime dt;
+  parse_error err;
+  EXPECT_FALSE(parse<format::iso8601>("1994-02-03", dt, err));
+  EXPECT_EQ(parse_status::too_short, err.status);
+  EXPECT_FALSE(parse<format::iso8601>("1994/02/03T14:15:29Z", dt, err));
+  EXPECT_EQ(parse_status::expected_delimiter, err.status);
+  EXPECT_EQ(4u, err.offset);
+  EXPECT_FALSE(parse<format::iso8601>("1994-02-03T14:75:29Z", dt, err));
+  EXPECT_EQ(parse_status::bad_minute, err.status);
+  EXPECT_EQ(14u, err.offset);
+  EXPECT_FALSE(parse<format::iso8601>("1994-02-30T14:15:29Z", dt, err));
+  EXPECT_EQ(parse_status::invalid_date, err.status);
+  EXPECT_FALSE(parse<format::rfc1123>("Wed, 09 Fev 1994 22:23:32 GMT", dt, err));
+  EXPECT_EQ(parse_status::bad_month, err.status);
+  EXPECT_EQ(8u, err.offset);
+  EXPECT_FALSE(parse<format::rfc1123>("1994-02-03T14:15:29.123456789Z", dt, err));
+  EXPECT_EQ(parse_status::bad_weekday, err.status);
+  EXPECT_FALSE(parse<format::clf>("03/Feb/1994:17:03:55 -2500", dt, err));
+  EXPECT_EQ(parse_status::bad_zone, err.status);
+
+  timestamp t;
+  EXPECT_TRUE(parse<format::clf>("03/Feb/1994:17:03:55 -0700", t, err));
+  EXPECT_EQ(epoch_from_string("03/Feb/1994:17:03:55 -0700"), t.sec);
+}
+
+TEST(datetimeliteTest, testSwar)
+{
+  using namespace datetimelite::detail;
+  EXPECT_TRUE(all_digits8(load8("19940203")));
+  EXPECT_FALSE(all_digits8(load8("1994-02-")));
+  EXPECT_FALSE(all_digits8(load8("1994020:")));
+  EXPECT_FALSE(all_digits8(load8("/9940203")));
+  EXPECT_FALSE(all_digits8(load8("1994\xff" "203")));
+  EXPECT_EQ(12345678u, digits8_value(load8("12345678")));
+  EXPECT_EQ(99999999u, digits8_value(load8("99999999")));
+  EXPECT_EQ(0u, digits8_value(load8("00000000")));
+  uint64_t pairs = digit_pairs8(squeeze_date("1994-02-03"));
+  EXPECT_EQ(19, lane(pairs, 0));
+  EXPECT_EQ(94, lane(pairs, 1));
+  EXPECT_EQ(2, lane(pairs, 2));
+  EXPECT_EQ(3, lane(pairs, 3));
+  pairs = digit_pairs8(squeeze_time("14:15:29"));
+  EXPECT_EQ(14, lane(pairs, 0));
+  EXPECT_EQ(15, lane(pairs, 1));
+  EXPECT_EQ(29, lane(pairs, 2));
+  EXPECT_EQ(0, lane(pairs, 3));
+
+  // the byte-wise path still covers what the word decoders decline
+  EXPECT_EQ("Year:1994|Month:2|Day:3|Hour:14|Min:15|Sec:29", getdatetimestring("1994/02/03 14:15:29"));
+  EXPECT_EQ("Year:1994|Month:2|Day:3|Hour:14|Min:15|Sec:0", getdatetimestring("1994-02-03 14:15"));
+  EXPECT_EQ("Year:1994|Month:2|Day:3|Hour:14|Min:15|Sec:0", getdatetimestring("1994-0203T1415"));
+  EXPECT_EQ("Year:1994|Month:2|Day:3|Hour:24|Min:0|Sec:0", getdatetimestring("1994-02-03 24:00:00"));
+  EXPECT_THROW(getdatetimestring("1994-02-03 14:65:00"), std::invalid_argument);
+  EXPECT_THROW(getdatetimestring("1899-02-03 14:15:00"), std::invalid_argument);
+}
+
+typedef bool (*canonical_kernel)(const char*, std::size_t, datetimelite::datetime&);
+
+void expectCanonical(canonical_kernel kernel)
+{
+  const char* accepted[] = {
+    "1994-02-03T14:15:29Z",
+    "1994-02-03T14:15:29.1Z",
+    "1994-02-03T14:15:29.123456Z",
+    "1994-02-03T14:15:29.123456789Z",
+    "2000-02-29T24:00:61Z",
+  };
+  const char* rejected[] = {
+    "1994-02-03 14:15:29Z",
+    "1994-02-03T14:15:29.Z",
+    "1994-02-03T14:15:29,5Z",
+    "1994-02-03T14:15:29.12a4Z",
+    "1994-02-30T14:15:29Z",
+    "1899-12-31T14:15:29Z",
+    "1994-13-03T14:15:29Z",
+    "1994-00-03T14:15:29Z",
+    "1994-02-00T14:15:29Z",
+    "1994-02-03T25:15:29Z",
+    "1994-02-03T14:60:29Z",
+    "1994-02-03T14:15:62Z",
+    "1994-02-03T14-15-29Z",
+    "1994/02/03T14:15:29Z",
+    "19a4-02-03T14:15:29Z",
+  };
+  for (size_t i = 0; i < sizeof(accepted) / sizeof(accepted[0]); ++i) {
+    datetimelite::datetime expected, actual;
+    datetimelite::parse_error err;
+    ASSERT_TRUE(datetimelite::try_parse(accepted[i], expected, err));
+    ASSERT_TRUE(datetimelite::detail::canonical_candidate(accepted[i], std::strlen(accepted[i])));
+    ASSERT_TRUE(kernel(accepted[i], std::strlen(accepted[i]), actual)) << accepted[i];
+    EXPECT_EQ(datetimelite::to_epoch(expected), datetimelite::to_epoch(actual)) << accepted[i];
+    EXPECT_EQ(expected.nsec, actual.nsec) << accepted[i];
+    EXPECT_EQ(0, actual.utc_offset) << accepted[i];
+  }
+  for (size_t i = 0; i < sizeof(rejected) / sizeof(rejected[0]); ++i) {
+    datetimelite::datetime actual;
+    EXPECT_FALSE(datetimelite::detail::canonical_candidate(rejected[i], std::strlen(rejected[i]))
+                 && kernel(rejected[i], std::strlen(rejected[i]), actual)) << rejected[i];
+  }
+}
+
+TEST(datetimeliteTest, testCanonical)
+{
+  expectCanonical(datetimelite::detail::parse_canonical_scalar);
+#if defined(DATETIMELITE_X86_KERNELS)
+  if (__builtin_cpu_supports("sse4.2"))
+    expectCanonical(datetimelite::detail::parse_canonical_sse42);
+  if (__builtin_cpu_supports("avx2"))
+    expectCanonical(datetimelite::detail::parse_canonical_avx2);
+#endif
+  RecordProperty("kernel", datetimelite::kernel_name());
+}
+
+TEST(datetimeliteTest, testMonthName)
+{
+  using datetimelite::detail::month_from_name;
+  const char* names[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+  for (int i = 0; i < 12; ++i) {
+    EXPECT_EQ(i + 1, month_from_name(names[i])) << names[i];
+    std::string upper(names[i]), lower(names[i]);
+    for (int j = 0; j < 3; ++j) {
+      upper[j] = std::toupper(upper[j]);
+      lower[j] = std::tolower(lower[j]);
+    }
+    EXPECT_EQ(0, month_from_name(upper.c_str())) << upper;
+    EXPECT_EQ(0, month_from_name(lower.c_str())) << lower;
+    EXPECT_EQ(i + 1, month_from_name(upper.c_str(), true)) << upper;
+    EXPECT_EQ(i + 1, month_from_name(lower.c_str(), true)) << lower;
+  }
+  EXPECT_EQ(0, month_from_name("Jam"));
+  EXPECT_EQ(0, month_from_name("   "));
+  EXPECT_EQ(0, month_from_name("   ", true));
+  EXPECT_EQ(0, month_from_name("J@N", true));
+  EXPECT_EQ(0, month_from_name("\x80\x80\x80", true));
+}
+
+TEST(datetimeliteTest, testZoneRegistry)
+{
+  using datetimelite::zone_registry;
+  EXPECT_EQ("Offset:-18000|Year:1994|Month:2|Day:3|Hour:19|Min:15|Sec:29", getutcstring("1994-02-03 14:15:29 EST"));
+  EXPECT_EQ("Offset:-25200|Year:1994|Month:2|Day:3|Hour:21|Min:15|Sec:29", getutcstring("1994-02-03 14:15:29 PDT"));
+  EXPECT_EQ("Offset:0|Year:1994|Month:2|Day:3|Hour:14|Min:15|Sec:29", getutcstring("1994-02-03 14:15:29 UT"));
+  EXPECT_EQ("Offset:3600|Year:1994|Month:2|Day:3|Hour:13|Min:15|Sec:29", getutcstring("1994-02-03 14:15:29 A"));
+  EXPECT_EQ("Offset:-43200|Year:1994|Month:2|Day:4|Hour:2|Min:15|Sec:29", getutcstring("1994-02-03 14:15:29 Y"));
+
+  EXPECT_EQ("format not supported: unknown timezone", getutcstring("1994-02-03 14:15:29 JST"));
+  datetimelite::datetime dt;
+  datetimelite::parse_error err;
+  EXPECT_FALSE(datetimelite::try_parse("Wed, 09 Feb 1994 22:23:32 XYZ", dt, err));
+  EXPECT_EQ(datetimelite::parse_status::unknown_zone, err.status);
+  EXPECT_EQ(26u, err.offset);
+
+  EXPECT_TRUE(zone_registry::instance().add("JST", 9 * 3600));
+  EXPECT_TRUE(zone_registry::instance().add("NPT", 5 * 3600 + 45 * 60));
+  EXPECT_EQ("Offset:32400|Year:1994|Month:2|Day:3|Hour:5|Min:15|Sec:29", getutcstring("1994-02-03 14:15:29 JST"));
+  EXPECT_EQ("Offset:20700|Year:1994|Month:2|Day:3|Hour:8|Min:30|Sec:29", getutcstring("1994-02-03 14:15:29 NPT"));
+
+  // a site can override an ambiguous abbreviation
+  int offset;
+  EXPECT_TRUE(zone_registry::instance().add("IST", 2 * 3600));
+  EXPECT_TRUE(zone_registry::instance().add("IST", 5 * 3600 + 30 * 60));
+  EXPECT_TRUE(zone_registry::instance().find("IST", offset));
+  EXPECT_EQ(19800, offset);
+
+  EXPECT_FALSE(zone_registry::instance().add("", 0));
+  EXPECT_FALSE(zone_registry::instance().add("TOOLONG", 0));
+  EXPECT_FALSE(zone_registry::instance().add("ODD", 30));
+  EXPECT_FALSE(zone_registry::instance().add("FAR", 25 * 3600));
+  EXPECT_FALSE(zone_registry::instance().find(std::string_view("Z\0", 2), offset));
+  EXPECT_FALSE(zone_registry::instance().find("ZZ", offset));
+}
+
+
+template <typename Format>
+std::string writestring(int64_t sec, int32_t nsec = 0, int offset = 0)
+{
+  char buf[Format::max_size];
+  datetimelite::timestamp t = { sec, nsec };
+  return std::string(buf, datetimelite::format_to<Format>(buf, t, offset));
+}
+
+TEST(datetimeliteTest, testWrite)
+{
+  using namespace datetimelite;
+  EXPECT_EQ("1994-02-03T14:15:29Z", writestring<format::iso8601>(760284929));
+  EXPECT_EQ("1994-02-03T14:15:29.120Z", writestring<format::iso8601>(760284929, 120000000));
+  EXPECT_EQ("1994-02-03T14:15:29.000120Z", writestring<format::iso8601>(760284929, 120000));
+  EXPECT_EQ("1994-02-03T14:15:29.000000001Z", writestring<format::iso8601>(760284929, 1));
+  EXPECT_EQ("1994-02-03T23:15:29+09:00", writestring<format::iso8601>(760284929, 0, 9 * 3600));
+  EXPECT_EQ("1994-02-03T12:45:29-01:30", writestring<format::iso8601>(760284929, 0, -5400));
+  EXPECT_EQ("Wed, 09 Feb 1994 22:23:32 GMT", writestring<format::rfc1123>(760832612));
+  EXPECT_EQ("Wed, 09 Feb 1994 22:23:32 GMT", writestring<format::rfc1123>(760832612, 5, 3600));
+  EXPECT_EQ("03/Feb/1994:17:03:55 -0700", writestring<format::clf>(760320235, 0, -7 * 3600));
+  EXPECT_EQ("04/Feb/1994:00:03:55 +0000", writestring<format::clf>(760320235));
+  EXPECT_EQ("Thu, 01 Jan 1970 00:00:00 GMT", writestring<format::rfc1123>(0));
+  EXPECT_EQ("Wed, 31 Dec 1969 23:59:59 GMT", writestring<format::rfc1123>(-1));
+  EXPECT_EQ("", writestring<format::iso8601>(253402300800));  // 10000-01-01
+
+  // a parsed datetime writes back as it was read
+  datetime dt;
+  parse_error err;
+  char buf[format::iso8601::max_size];
+  ASSERT_TRUE(parse<format::clf>("03/Feb/1994:17:03:55 -0700", dt, err));
+  EXPECT_EQ("03/Feb/1994:17:03:55 -0700", std::string(buf, format_to<format::clf>(buf, dt)));
+  ASSERT_TRUE(parse<format::iso8601>("1994-02-03T14:15:29.5+05:45", dt, err));
+  EXPECT_EQ("1994-02-03T14:15:29.500+05:45", std::string(buf, format_to<format::iso8601>(buf, dt)));
+
+  // same as strftime in the C locale, over four centuries either way
+  for (int64_t t = -12219292800; t < 32503680000; t += 86400 * 37 + 3631) {
+    time_t tt = static_cast<time_t>(t);
+    struct std::tm tm;
+    gmtime_r(&tt, &tm);
+    char expected[64];
+    strftime(expected, sizeof(expected), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    ASSERT_EQ(expected, writestring<format::rfc1123>(t)) << t;
+    strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    ASSERT_EQ(expected, writestring<format::iso8601>(t)) << t;
+    int64_t back;
+    if (t > -2208988800 + 86400) {  // the parser takes 1900 onwards
+      ASSERT_TRUE(try_parse_epoch(writestring<format::clf>(t, 0, -8 * 3600), back, err)) << t;
+      ASSERT_EQ(t, back);
+    }
+  }
+}
+
+TEST(datetimeliteTest, testCivil)
+{
+  using namespace datetimelite;
+  static_assert(days_from_civil(1970, 1, 1) == 0, "epoch");
+  static_assert(days_from_civil(2000, 3, 1) == 11017, "after a leap day");
+  static_assert(days_from_civil(1969, 12, 31) == -1, "before the epoch");
+  static_assert(to_epoch(datetime{ 1994, 2, 3, 14, 15, 29, 0, 0 }) == 760284929, "to_epoch");
+  static_assert(from_epoch(760284929).mday == 3, "from_epoch");
+  static_assert(days_in_month(2000, 2) == 29 && days_in_month(1900, 2) == 28, "february");
+  static_assert(!check_date(2011, 4, 31) && check_date(2011, 12, 31), "check_date");
+
+  const int expected_days[13] = { 0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+  for (int m = 0; m <= 13; ++m)
+    EXPECT_EQ(m >= 1 && m <= 12 ? expected_days[m] : 0, days_in_month(2011, m)) << m;
+
+  // every day from 1600 to 2400 follows the one before it
+  int64_t z = days_from_civil(1600, 1, 1);
+  for (int y = 1600; y < 2400; ++y) {
+    for (int m = 1; m <= 12; ++m) {
+      for (int d = 1; d <= days_in_month(y, m); ++d, ++z) {
+        ASSERT_EQ(z, days_from_civil(y, m, d)) << y << "-" << m << "-" << d;
+        int yy, mm, dd;
+        civil_from_days(z, yy, mm, dd);
+        ASSERT_TRUE(yy == y && mm == m && dd == d) << z;
+      }
+    }
+  }
+
+  // and far either way, out to the ends of int
+  const int years[] = { -2147483647 - 1, -1000000, -4713, -1, 0, 1, 1000000, 2147483647 };
+  for (int y : years) {
+    for (int m = 1; m <= 12; ++m) {
+      int yy, mm, dd;
+      civil_from_days(days_from_civil(y, m, 1), yy, mm, dd);
+      EXPECT_TRUE(yy == y && mm == m && dd == 1) << y << "-" << m;
+      EXPECT_EQ(days_from_civil(y, m, 1) + 31, days_from_civil(y, m, 32)) << y << "-" << m;
+    }
+    EXPECT_EQ(365 + (y % 4 == 0 && (y % 100 != 0 || y % 400 == 0)),
+              days_from_civil(static_cast<int64_t>(y) + 1, 1, 1) - days_from_civil(y, 1, 1)) << y;
+  }
+  EXPECT_EQ(146097, days_from_civil(2400, 1, 1) - days_from_civil(2000, 1, 1));
+  EXPECT_EQ(-719468, days_from_civil(0, 3, 1));
+}
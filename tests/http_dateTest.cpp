@@ -0,0 +1,63 @@
+#include "datetimelite/http_date.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace datetimelite;
+
+static std::string
+rfc1123(http_date& d, int64_t now)
+{
+  char buf[http_date::rfc1123_size];
+  return std::string(buf, d.rfc1123(buf, now));
+}
+
+static std::string
+clf(http_date& d, int64_t now)
+{
+  char buf[http_date::clf_size];
+  return std::string(buf, d.clf(buf, now));
+}
+
+TEST(http_dateTest, testStrings)
+{
+  http_date d(-7 * 3600);
+  EXPECT_EQ("Fri, 04 Feb 1994 00:03:55 GMT", rfc1123(d, 760320235));
+  EXPECT_EQ("03/Feb/1994:17:03:55 -0700", clf(d, 760320235));
+  EXPECT_EQ("Fri, 04 Feb 1994 00:03:55 GMT", rfc1123(d, 760320235));
+  EXPECT_EQ("Fri, 04 Feb 1994 00:03:56 GMT", rfc1123(d, 760320236));
+  EXPECT_EQ("03/Feb/1994:17:03:56 -0700", clf(d, 760320236));
+  // a clock stepped back is just another second
+  EXPECT_EQ("Fri, 04 Feb 1994 00:03:55 GMT", rfc1123(d, 760320235));
+
+  http_date utc;
+  char buf[http_date::rfc1123_size];
+  ASSERT_EQ(http_date::rfc1123_size, utc.rfc1123(buf));
+  EXPECT_EQ(0, std::memcmp(buf + 25, " GMT", 4));
+}
+
+TEST(http_dateTest, testThreads)
+{
+  http_date d;
+  std::atomic<int> bad(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&d, &bad, i] {
+      for (int n = 0; n < 20000; ++n) {
+        const int64_t now = 760320235 + (n + i) / 1000;
+        char buf[http_date::rfc1123_size];
+        char expected[http_date::rfc1123_size];
+        const timestamp t = { now, 0 };
+        d.rfc1123(buf, now);
+        format_to<format::rfc1123>(expected, t);
+        if (std::memcmp(buf, expected, sizeof(buf)) != 0)
+          ++bad;
+      }
+    });
+  }
+  for (std::thread& t : threads)
+    t.join();
+  EXPECT_EQ(0, bad.load());
+}
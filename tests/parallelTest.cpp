@@ -0,0 +1,137 @@
+#include "datetimelite/parallel.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace datetimelite;
+
+TEST(parallelTest, testParallelFor)
+{
+  for (unsigned threads : { 1u, 2u, 4u, 7u }) {
+    thread_pool pool(threads);
+    EXPECT_EQ(threads, pool.size());
+    for (size_t chunks : { 0, 1, 2, 3, 100, 1001 }) {
+      std::vector<std::atomic<int>> hits(chunks);
+      pool.parallel_for(chunks, [&](size_t i) { hits[i]++; });
+      for (size_t i = 0; i < chunks; ++i)
+        ASSERT_EQ(1, hits[i].load()) << threads << " threads, chunk " << i << " of " << chunks;
+    }
+  }
+}
+
+TEST(parallelTest, testNamedCallable)
+{
+  thread_pool pool(3);
+  std::vector<std::atomic<int>> hits(100);
+  auto count = [&](size_t i) { hits[i]++; };
+  pool.parallel_for(hits.size(), count);
+  const auto& const_count = count;
+  pool.parallel_for(hits.size(), const_count);
+  struct counter {
+    std::vector<std::atomic<int>>& hits;
+    void operator()(size_t i) { hits[i]++; }
+  } functor = { hits };
+  pool.parallel_for(hits.size(), functor);
+  for (size_t i = 0; i < hits.size(); ++i)
+    EXPECT_EQ(3, hits[i].load()) << i;
+}
+
+TEST(parallelTest, testUneven)
+{
+  // a few slow chunks at the front, so the other threads have to steal
+  thread_pool pool(4);
+  std::vector<std::atomic<int>> hits(64);
+  pool.parallel_for(hits.size(), [&](size_t i) {
+    if (i < 4)
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    hits[i]++;
+  });
+  for (size_t i = 0; i < hits.size(); ++i)
+    EXPECT_EQ(1, hits[i].load()) << i;
+}
+
+TEST(parallelTest, testParseBatch)
+{
+  const char* samples[] = {
+    "1994-02-03T14:15:29Z",
+    "1994-02-03T14:15:29.123+09:00",
+    "Wed, 09 Feb 1994 22:23:32 GMT",
+    "03/Feb/1994:17:03:55 -0700",
+    "bogus",
+    "1994-02-30",
+    "20001231T235959Z",
+  };
+  std::vector<std::string> values;
+  for (size_t i = 0; i < 10007; ++i)
+    values.push_back(samples[(i * 7 + i / 3) % 7]);
+  std::vector<std::string_view> views(values.begin(), values.end());
+  std::string data;
+  std::vector<int32_t> offsets = { 0 };
+  for (const std::string& v : values) {
+    data += v;
+    offsets.push_back(static_cast<int32_t>(data.size()));
+  }
+  const size_t n = values.size();
+
+  std::vector<int64_t> sec(n), expected_sec(n);
+  std::vector<int32_t> nsec(n), expected_nsec(n);
+  std::vector<int16_t> offset(n), expected_offset(n);
+  std::vector<uint8_t> valid((n + 7) / 8), expected_valid((n + 7) / 8);
+  epoch_columns out = { sec.data(), nsec.data(), offset.data(), valid.data() };
+  epoch_columns expected = { expected_sec.data(), expected_nsec.data(), expected_offset.data(), expected_valid.data() };
+  const size_t count = parse_batch(views.data(), n, expected);
+
+  thread_pool pool(4);
+  for (size_t chunk_rows : { 1, 8, 100, 4096 }) {
+    std::fill(valid.begin(), valid.end(), 0xaa);
+    EXPECT_EQ(count, parse_batch(pool, views.data(), n, out, chunk_rows));
+    EXPECT_EQ(expected_valid, valid);
+    EXPECT_EQ(expected_sec, sec);
+    EXPECT_EQ(expected_nsec, nsec);
+    EXPECT_EQ(expected_offset, offset);
+
+    std::fill(valid.begin(), valid.end(), 0xaa);
+    EXPECT_EQ(count, parse_batch(pool, data.data(), offsets.data(), n, out, nullptr, chunk_rows));
+    EXPECT_EQ(expected_valid, valid);
+    EXPECT_EQ(expected_sec, sec);
+  }
+}
+
+TEST(parallelTest, testScanLines)
+{
+  std::string log;
+  for (int i = 0; i < 5000; ++i) {
+    char line[128];
+    const int len = std::snprintf(line, sizeof(line), "1994-02-03T14:%02d:%02dZ %.*s%s", i / 60 % 60, i % 60,
+                                  i % 37, "....................................", i % 11 == 0 ? "\r\n" : "\n");
+    log.append(line, len);
+    if (i % 13 == 0)
+      log += "not a timestamp\n\n";
+  }
+  log += "1994-02-03T15:00:00Z no newline";
+  scan_options opt;
+  opt.terminator = ' ';
+
+  line_times expected;
+  const scan_result r = scan_lines(log.data(), log.size(), opt, [&expected](uint64_t offset, int64_t epoch) {
+    expected.offset.push_back(offset);
+    expected.epoch.push_back(epoch);
+  });
+  EXPECT_EQ(5001u, r.parsed);
+
+  thread_pool pool(3);
+  for (size_t chunk_bytes : { 1, 7, 64, 1000, 1 << 20 }) {
+    line_times out;
+    const scan_result p = scan_lines(pool, log.data(), log.size(), opt, out, chunk_bytes);
+    EXPECT_EQ(r.lines, p.lines) << chunk_bytes;
+    EXPECT_EQ(r.parsed, p.parsed) << chunk_bytes;
+    EXPECT_EQ(expected.offset, out.offset) << chunk_bytes;
+    EXPECT_EQ(expected.epoch, out.epoch) << chunk_bytes;
+  }
+
+  line_times none;
+  EXPECT_EQ(0u, scan_lines(pool, log.data(), 0, opt, none).lines);
+}
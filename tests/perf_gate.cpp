@@ -0,0 +1,171 @@
+// Fails when the parser behind time_from_string got slower on any
+// layout of the benchmark corpus than tests/perf_baseline.json allows.
+//
+//   perf_gate BASELINE TOLERANCE_PERCENT [--update]
+//
+// Machines differ, so neither the baseline nor the measurement is in
+// ns: each layout's time per parse is divided by the time per input of
+// a calibration loop that reads the same bytes with the same kind of
+// branches. --update rewrites BASELINE with the ratios of this build.
+
+#include "datetimelite.h"
+#include "corpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const std::size_t rows = 20000;
+const uint64_t seed = 1;
+const std::size_t batch_rows = 250;  // a few µs, well inside a timeslice
+const int trials = 25;
+
+volatile int64_t sink;
+
+// try_parse to struct std::tm, the work of time_from_string without
+// the exception, whose unwinding would dominate the invalid layout.
+int64_t
+parse_rows(const bench::corpus& c, std::size_t begin, std::size_t end)
+{
+  int64_t acc = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    struct std::tm tm;
+    datetimelite::parse_error err;
+    acc += datetimelite::try_parse(c.c_str(i), c.length(i), tm, err) ? tm.tm_sec : -1;
+  }
+  return acc;
+}
+
+// Digits into a number, everything else into a hash: about the work
+// of a parser that does nothing clever.
+int64_t
+calibration_rows(const bench::corpus& c, std::size_t begin, std::size_t end)
+{
+  int64_t acc = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    const char* s = c.c_str(i);
+    uint64_t n = 0, h = 0;
+    for (std::size_t k = 0; k < c.length(i); ++k) {
+      const unsigned d = static_cast<unsigned char>(s[k]) - '0';
+      if (d < 10)
+        n = n * 10 + d;
+      else
+        h = h * 31 + static_cast<unsigned char>(s[k]);
+    }
+    acc += static_cast<int64_t>(n ^ h);
+  }
+  return acc;
+}
+
+// Time of the parser over c divided by that of the calibration loop.
+// Both are timed in batches of batch_rows rows, each batch trials
+// times with the two loops alternating, and a batch counts with its
+// fastest time: a batch is short enough that some of its trials run
+// without being preempted, whatever else the machine is doing.
+double
+parse_ratio(const bench::corpus& c)
+{
+  int64_t acc = calibration_rows(c, 0, c.size()) + parse_rows(c, 0, c.size());
+  double total[2] = { 0, 0 };
+  for (std::size_t begin = 0; begin < c.size(); begin += batch_rows) {
+    const std::size_t end = std::min(begin + batch_rows, c.size());
+    double best[2] = { 1e300, 1e300 };
+    for (int t = 0; t < trials; ++t) {
+      for (int k = 0; k < 2; ++k) {
+        const auto start = std::chrono::steady_clock::now();
+        acc += k ? parse_rows(c, begin, end) : calibration_rows(c, begin, end);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best[k] = std::min(best[k], elapsed.count());
+      }
+    }
+    total[0] += best[0];
+    total[1] += best[1];
+  }
+  sink = acc;
+  return total[1] / total[0];
+}
+
+// The number after "name": in json, or -1.
+double
+baseline_ratio(const std::string& json, const char* name)
+{
+  const std::string key = std::string("\"") + name + "\":";
+  const std::size_t at = json.find(key);
+  if (at == std::string::npos)
+    return -1;
+  return std::strtod(json.c_str() + at + key.size(), nullptr);
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc < 3 || (argc == 4 && std::strcmp(argv[3], "--update") != 0) || argc > 4) {
+    std::fprintf(stderr, "usage: perf_gate BASELINE TOLERANCE_PERCENT [--update]\n");
+    return 2;
+  }
+  const char* path = argv[1];
+  const double tolerance = std::atof(argv[2]);
+  const bool update = argc == 4;
+
+  std::string json;
+  if (!update) {
+    std::ifstream in(path);
+    if (!in) {
+      std::perror(path);
+      return 2;
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    json = ss.str();
+  }
+
+  std::ostringstream out;
+  out << "{\n";
+  int failures = 0;
+  for (std::size_t f = 0; f < sizeof(bench::all_formats) / sizeof(bench::all_formats[0]); ++f) {
+    const bench::corpus_format format = bench::all_formats[f];
+    const char* name = bench::format_name(format);
+    const bench::corpus c = bench::make_corpus(format, rows, seed);
+    const double ratio = parse_ratio(c);
+    char line[128];
+    std::snprintf(line, sizeof(line), "  \"%s\": %.3f%s\n", name, ratio,
+                  f + 1 < sizeof(bench::all_formats) / sizeof(bench::all_formats[0]) ? "," : "");
+    out << line;
+    if (update)
+      continue;
+
+    const double base = baseline_ratio(json, name);
+    if (base <= 0) {
+      std::printf("%-12s %8.3f  no baseline\n", name, ratio);
+      continue;
+    }
+    const double change = (ratio / base - 1) * 100;
+    const bool slower = change > tolerance;
+    failures += slower;
+    std::printf("%-12s %8.3f  baseline %8.3f  %+6.1f%%%s\n", name, ratio, base, change,
+                slower ? "  SLOWER" : "");
+  }
+  out << "}\n";
+
+  if (update) {
+    std::ofstream o(path);
+    o << out.str();
+    if (!o) {
+      std::perror(path);
+      return 2;
+    }
+    std::fputs(out.str().c_str(), stdout);
+    return 0;
+  }
+  if (failures)
+    std::printf("%d layout(s) more than %.0f%% slower than %s\n", failures, tolerance, path);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,116 @@
+#include "datetimelite/scan.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace datetimelite;
+
+class temp_file {
+public:
+  explicit temp_file(const std::string& content)
+  {
+    char name[] = "/tmp/datetimelite_scanXXXXXX";
+    const int fd = mkstemp(name);
+    path_ = name;
+    if (fd >= 0) {
+      EXPECT_EQ(static_cast<ssize_t>(content.size()), write(fd, content.data(), content.size()));
+      close(fd);
+    }
+  }
+  ~temp_file() { unlink(path_.c_str()); }
+  const std::string& path() const { return path_; }
+private:
+  std::string path_;
+};
+
+typedef std::vector<std::pair<uint64_t, int64_t> > hits;
+
+static hits
+scan(const std::string& s, const scan_options& opt, scan_result* result = nullptr)
+{
+  hits h;
+  scan_result r = scan_lines(s.data(), s.size(), opt, [&h](uint64_t offset, int64_t epoch) {
+    h.push_back(std::make_pair(offset, epoch));
+  });
+  if (result)
+    *result = r;
+  return h;
+}
+
+TEST(scanTest, testTerminator)
+{
+  const std::string log =
+    "1994-02-03T14:15:29Z GET /\n"
+    "garbage\n"
+    "\n"
+    "1994-02-03T14:15:30.5Z POST /x\r\n"
+    "1994-02-03T14:15:31Z";
+  scan_options opt;
+  opt.terminator = ' ';
+  scan_result r;
+  hits h = scan(log, opt, &r);
+  EXPECT_EQ(5u, r.lines);
+  EXPECT_EQ(3u, r.parsed);
+  ASSERT_EQ(3u, h.size());
+  EXPECT_EQ(std::make_pair(uint64_t(0), int64_t(760284929)), h[0]);
+  EXPECT_EQ(std::make_pair(uint64_t(36), int64_t(760284930)), h[1]);
+  EXPECT_EQ(std::make_pair(uint64_t(68), int64_t(760284931)), h[2]);
+}
+
+TEST(scanTest, testPrefix)
+{
+  const std::string log =
+    "127.0.0.1 - - [03/Feb/1994:17:03:55 -0700] \"GET / HTTP/1.0\" 200 5\n"
+    "127.0.0.1 - - \"no timestamp\"\n"
+    "10.0.0.1 - frank [04/Feb/1994:00:03:56 +0000] \"GET / HTTP/1.0\" 200 5\n";
+  scan_options opt;
+  opt.prefix = "[";
+  opt.terminator = ']';
+  hits h = scan(log, opt);
+  ASSERT_EQ(2u, h.size());
+  EXPECT_EQ(0u, h[0].first);
+  EXPECT_EQ(760320235, h[0].second);
+  EXPECT_EQ(log.find("10.0.0.1"), h[1].first);
+  EXPECT_EQ(760320236, h[1].second);
+}
+
+TEST(scanTest, testColumnWidth)
+{
+  const std::string log =
+    "I 1994-02-03 14:15:29.250 started\n"
+    "W 1994-02-03 14:15:3\n"
+    "E 1994-02-03 14:16:29.000 stopped\n";
+  scan_options opt;
+  opt.column = 2;
+  opt.width = 23;
+  hits h = scan(log, opt);
+  ASSERT_EQ(2u, h.size());
+  EXPECT_EQ(760284929, h[0].second);
+  EXPECT_EQ(760284989, h[1].second);
+
+  // without the width the rest of the line is part of the timestamp
+  opt.width = 0;
+  EXPECT_TRUE(scan(log, opt).empty());
+}
+
+TEST(scanTest, testFile)
+{
+  temp_file f("1994-02-03T14:15:29Z a\n1994-02-03T14:15:30Z b\n");
+  scan_options opt;
+  opt.terminator = ' ';
+  line_times out;
+  scan_result r = scan_file(f.path(), opt, out);
+  EXPECT_EQ(2u, r.parsed);
+  EXPECT_EQ((std::vector<uint64_t>{ 0, 23 }), out.offset);
+  EXPECT_EQ((std::vector<int64_t>{ 760284929, 760284930 }), out.epoch);
+
+  temp_file empty("");
+  line_times none;
+  EXPECT_EQ(0u, scan_file(empty.path(), opt, none).lines);
+  EXPECT_THROW(scan_file("/nonexistent/datetimelite.log", opt, none), std::system_error);
+}
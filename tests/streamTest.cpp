@@ -0,0 +1,108 @@
+#include "datetimelite/stream.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace datetimelite;
+
+static void
+expect_same(stream_parser& p, const std::string& s)
+{
+  datetime a, b;
+  parse_error ea, eb;
+  const bool ok = try_parse(s, a, ea);
+  ASSERT_EQ(ok, p.parse(s, b, eb)) << s;
+  ASSERT_EQ(ea.status, eb.status) << s;
+  ASSERT_EQ(ea.offset, eb.offset) << s;
+  if (ok) {
+    ASSERT_EQ(to_epoch(a), to_epoch(b)) << s;
+    ASSERT_EQ(a.nsec, b.nsec) << s;
+    ASSERT_EQ(a.utc_offset, b.utc_offset) << s;
+    ASSERT_EQ(a.hour, b.hour) << s;
+  }
+}
+
+static const char* layouts[] = {
+  "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+  "%04d-%02d-%02dT%02d:%02d:%02dZ",
+  "%04d-%02d-%02d %02d:%02d:%02d,%06d +0900",
+  "%02d/%3s/%04d:%02d:%02d:%02d -0700",
+  "Wed, %02d %3s %04d %02d:%02d:%02d GMT",
+  "%04d%02d%02dT%02d%02d%02dZ",
+};
+
+static std::string
+line(int layout, int64_t t, int frac)
+{
+  static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+  const datetime dt = from_epoch(t);
+  char buf[128];
+  const int h = dt.hour, mi = dt.min, s = dt.sec;
+  switch (layout) {
+  case 0: std::snprintf(buf, sizeof(buf), layouts[0], dt.year, dt.mon, dt.mday, h, mi, s, frac % 1000); break;
+  case 1: std::snprintf(buf, sizeof(buf), layouts[1], dt.year, dt.mon, dt.mday, h, mi, s); break;
+  case 2: std::snprintf(buf, sizeof(buf), layouts[2], dt.year, dt.mon, dt.mday, h, mi, s, frac); break;
+  case 3: std::snprintf(buf, sizeof(buf), layouts[3], dt.mday, months[dt.mon - 1], dt.year, h, mi, s); break;
+  case 4: std::snprintf(buf, sizeof(buf), layouts[4], dt.mday, months[dt.mon - 1], dt.year, h, mi, s); break;
+  default: std::snprintf(buf, sizeof(buf), layouts[5], dt.year, dt.mon, dt.mday, h, mi, s); break;
+  }
+  return buf;
+}
+
+TEST(streamTest, testMonotonic)
+{
+  for (int layout = 0; layout < 6; ++layout) {
+    stream_parser p;
+    int64_t t = 1485907195;  // 2017-02-01T00:00:-5
+    for (int i = 0; i < 20000; ++i, t += i % 3 == 0) {
+      expect_same(p, line(layout, t, i * 7919 % 1000000));
+      if (HasFatalFailure())
+        return;
+    }
+    if (layout != 5) {
+      EXPECT_GT(p.delta_parses(), 19000u) << layouts[layout];
+    }
+  }
+}
+
+TEST(streamTest, testMutated)
+{
+  // random bytes of the time and around it, and lines of other lengths
+  std::mt19937 rng(20110123);
+  const char bytes[] = "0123456789:.,-+ TZx";
+  for (int layout = 0; layout < 6; ++layout) {
+    stream_parser p;
+    int64_t t = 1485907195;
+    for (int i = 0; i < 20000; ++i) {
+      t += rng() % 90;
+      std::string s = line(layout, t, rng() % 1000000);
+      const int edits = rng() % 3;
+      for (int e = 0; e < edits; ++e) {
+        switch (rng() % 4) {
+        case 0: s.pop_back(); break;
+        case 1: s += bytes[rng() % (sizeof(bytes) - 1)]; break;
+        default: s[rng() % s.size()] = bytes[rng() % (sizeof(bytes) - 1)]; break;
+        }
+      }
+      expect_same(p, s);
+      if (HasFatalFailure())
+        return;
+    }
+  }
+}
+
+TEST(streamTest, testClfYear)
+{
+  // the year ends in digits that look like the time
+  stream_parser p;
+  expect_same(p, "03/Feb/2017:17:17:17 -0700");
+  expect_same(p, "03/Feb/2017:17:18:17 -0700");
+  expect_same(p, "03/Feb/2017:17:18:18 -0700");
+  EXPECT_EQ(2u, p.delta_parses());
+
+  p.reset();
+  expect_same(p, "03/Feb/2017:17:18:18 -0700");
+  EXPECT_EQ(2u, p.full_parses());
+}